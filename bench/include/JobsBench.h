@@ -0,0 +1,8 @@
+#ifndef JOBSBENCH_H
+#define JOBSBENCH_H
+
+/* This generated file contains includes for project dependencies */
+#include "bake_config.h"
+
+#endif
+
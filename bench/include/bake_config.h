@@ -0,0 +1,29 @@
+/*
+                                   )
+                                  (.)
+                                  .|.
+                                  | |
+                              _.--| |--._
+                           .-';  ;`-'& ; `&.
+                          \   &  ;    &   &_/
+                           |"""---...---"""|
+                           \ | | | | | | | /
+                            `---.|.|.|.---'
+
+ * This file is generated by bake.lang.c for your convenience. Headers of
+ * dependencies will automatically show up in this file. Include bake_config.h
+ * in your main project file. Do not edit! */
+
+#ifndef JOBSBENCH_BAKE_CONFIG_H
+#define JOBSBENCH_BAKE_CONFIG_H
+
+/* Headers of public dependencies */
+#include <Jobs.h>
+
+/* Headers of private dependencies */
+#ifdef JOBSBENCH_IMPL
+/* No dependencies */
+#endif
+
+#endif
+
@@ -0,0 +1,885 @@
+#include "JobsBench.h"
+#include "Jobs/CronSchedule.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Counting the allocations of the whole process, so the benchmarks can report allocations per job run
+// NOTE(yuval): GCC can't tell that the replaced operator new allocates with malloc
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<std::uint64_t> g_AllocationCount(0);
+static std::atomic<bool> g_CountAllocations(false);
+
+void* operator new(std::size_t size)
+{
+    if (g_CountAllocations.load(std::memory_order_relaxed))
+    {
+        g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* memory = std::malloc(size == 0 ? 1 : size);
+
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::vector<std::size_t> jobCounts = { 1000, 10000, 100000, 1000000 };
+        std::vector<unsigned int> workerCounts = { 1, 4, 16 };
+        std::vector<Jobs::JobStoreType::Type> storeTypes = { Jobs::JobStoreType::MultiMap, Jobs::JobStoreType::TimingWheel };
+        std::vector<Jobs::ExecutorType::Type> executorTypes = { Jobs::ExecutorType::ThreadPool };
+        std::vector<unsigned int> shardCounts = { 1, 2, 4, 8, 16, 32 };
+        bool runMicro = true;
+        std::string outputPath; // Standard output if empty
+    };
+
+    // A single measurement
+    struct Result
+    {
+        std::string benchmark;
+        std::size_t jobCount;
+        unsigned int workerCount;
+        std::string storeType;
+        std::string executorType;
+        unsigned int shardCount; // Zero for the benchmarks that don't run on a ShardedRunner
+        std::vector<std::pair<std::string, double>> values;
+    };
+
+    // The configuration that a scale benchmark runs with
+    struct Config
+    {
+        std::size_t jobCount;
+        unsigned int workerCount;
+        Jobs::JobStoreType::Type storeType;
+        Jobs::ExecutorType::Type executorType;
+        unsigned int shardCount = 0;
+    };
+
+    std::atomic<std::uint64_t> g_Fired(0);
+    bool g_Failed = false; // Set by the benchmarks that check an invariant, fails the run
+    volatile std::uint64_t g_Sink = 0; // Written by the benchmarked callables, so they aren't optimized away
+
+    void Noop()
+    {
+    }
+
+    void CountFired()
+    {
+        g_Fired.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // A function that is never scheduled, so looking it up scans all the jobs
+    void Missing()
+    {
+    }
+
+    const char* StoreName(Jobs::JobStoreType::Type type)
+    {
+        return type == Jobs::JobStoreType::TimingWheel ? "timing_wheel" : "multimap";
+    }
+
+    const char* ExecutorName(Jobs::ExecutorType::Type type)
+    {
+        switch (type)
+        {
+        case Jobs::ExecutorType::WorkStealing:
+            return "work_stealing";
+        case Jobs::ExecutorType::Inline:
+            return "inline";
+        default:
+            return "thread_pool";
+        }
+    }
+
+    inline double NanosecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    template <std::size_t Size>
+    struct Capture
+    {
+        std::uint64_t values[Size / sizeof(std::uint64_t)];
+    };
+
+    // Constructs a function from a lambda that captures the given number of bytes, moves it
+    // (like a job function is moved into its job) and invokes it, returns the total nanoseconds
+    template <typename Function, std::size_t Size>
+    double ConstructMoveInvoke(std::size_t count)
+    {
+        Capture<Size> capture = {};
+        Clock::time_point start = Clock::now();
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            capture.values[0] = i;
+
+            Function function([capture]() { g_Sink = g_Sink + capture.values[0]; });
+            Function moved(std::move(function));
+            moved();
+        }
+
+        return NanosecondsSince(start);
+    }
+
+    Result MakeResult(const std::string& benchmark, const Config& config)
+    {
+        Result result;
+        result.benchmark = benchmark;
+        result.jobCount = config.jobCount;
+        result.workerCount = config.workerCount;
+        result.storeType = StoreName(config.storeType);
+        result.executorType = ExecutorName(config.executorType);
+        result.shardCount = config.shardCount;
+
+        return result;
+    }
+
+    // Adds a result with the time per operation of an operation that ran the given number of times
+    void AddTiming(std::vector<Result>& results, const std::string& benchmark, const Config& config,
+                   double totalNanoseconds, std::size_t operations)
+    {
+        Result result = MakeResult(benchmark, config);
+        result.values.emplace_back("operations", static_cast<double>(operations));
+        result.values.emplace_back("ns_per_op", operations == 0 ? 0.0 : totalNanoseconds / operations);
+        result.values.emplace_back("ops_per_second", totalNanoseconds <= 0.0 ? 0.0 : operations * 1e9 / totalNanoseconds);
+
+        results.push_back(std::move(result));
+    }
+
+    // Waits until the given number of jobs fired, returns false if they didn't fire in time
+    bool WaitForFired(std::uint64_t count, std::chrono::seconds timeout)
+    {
+        Clock::time_point deadline = Clock::now() + timeout;
+
+        while (g_Fired.load(std::memory_order_relaxed) < count)
+        {
+            if (Clock::now() > deadline)
+            {
+                return false;
+            }
+
+            std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+    // Every().Do(), draining the inbox, NextRun(), IdleSeconds(), FindJob() and CancelJob()
+    void BenchRegistration(const Config& config, std::vector<Result>& results)
+    {
+        Jobs::Runner runner(config.workerCount, config.storeType, config.executorType);
+        std::vector<Jobs::JobHandle> handles;
+        handles.reserve(config.jobCount);
+
+        Clock::time_point start = Clock::now();
+
+        for (std::size_t i = 0; i < config.jobCount; ++i)
+        {
+            handles.push_back(runner.Every(1).Hours().Do(&Noop));
+        }
+
+        AddTiming(results, "every_do", config, NanosecondsSince(start), config.jobCount);
+
+        // The first query moves all the added jobs from the inbox to the job store
+        start = Clock::now();
+        runner.IdleSeconds();
+        AddTiming(results, "drain_inbox", config, NanosecondsSince(start), config.jobCount);
+
+        const std::size_t queryCount = 1000;
+        start = Clock::now();
+
+        for (std::size_t i = 0; i < queryCount; ++i)
+        {
+            runner.NextRun();
+        }
+
+        AddTiming(results, "next_run", config, NanosecondsSince(start), queryCount);
+
+        start = Clock::now();
+
+        for (std::size_t i = 0; i < queryCount; ++i)
+        {
+            runner.IdleSeconds();
+        }
+
+        AddTiming(results, "idle_seconds", config, NanosecondsSince(start), queryCount);
+
+        // NOTE(yuval): FindJob scans all the jobs, so the number of lookups shrinks as the jobs grow
+        const Jobs::JobFunction missing(&Missing);
+        std::size_t findCount = std::max<std::size_t>(3, std::min<std::size_t>(1000, 10000000 / (config.jobCount + 1)));
+        start = Clock::now();
+
+        for (std::size_t i = 0; i < findCount; ++i)
+        {
+            runner.FindJob(missing);
+        }
+
+        AddTiming(results, "find_job_miss", config, NanosecondsSince(start), findCount);
+
+        start = Clock::now();
+
+        for (const Jobs::JobHandle& handle : handles)
+        {
+            runner.CancelJob(handle);
+        }
+
+        AddTiming(results, "cancel_job", config, NanosecondsSince(start), handles.size());
+    }
+
+    // Every().Do() one by one until the jobs are stored, and the same jobs registered with a JobBatch
+    void BenchBatchRegistration(const Config& config, std::vector<Result>& results)
+    {
+        {
+            Jobs::Runner runner(config.workerCount, config.storeType, config.executorType);
+            Clock::time_point start = Clock::now();
+
+            for (std::size_t i = 0; i < config.jobCount; ++i)
+            {
+                runner.Every(1).Hours().Do(&Noop);
+            }
+
+            // The first query moves all the added jobs from the inbox to the job store
+            runner.IdleSeconds();
+            AddTiming(results, "register_single", config, NanosecondsSince(start), config.jobCount);
+        }
+
+        Jobs::Runner runner(config.workerCount, config.storeType, config.executorType);
+        Clock::time_point start = Clock::now();
+        Jobs::JobBatch batch(runner);
+
+        for (std::size_t i = 0; i < config.jobCount; ++i)
+        {
+            batch.Every(1).Hours().Do(&Noop);
+        }
+
+        batch.Commit();
+        AddTiming(results, "register_batch", config, NanosecondsSince(start), config.jobCount);
+    }
+
+    // AddJob() with jobs that were created up front
+    void BenchAddJob(const Config& config, std::vector<Result>& results)
+    {
+        Jobs::Runner runner(config.workerCount, config.storeType, config.executorType);
+        std::vector<Jobs::Job*> jobs;
+        jobs.reserve(config.jobCount);
+
+        for (std::size_t i = 0; i < config.jobCount; ++i)
+        {
+            jobs.push_back(new Jobs::Job(1, &runner));
+        }
+
+        JOB_TIME_TYPE runTime = JOB_CLOCK_TYPE::now() + std::chrono::hours(1);
+        Clock::time_point start = Clock::now();
+
+        for (Jobs::Job* job : jobs)
+        {
+            runner.AddJob(runTime, job);
+        }
+
+        AddTiming(results, "add_job", config, NanosecondsSince(start), jobs.size());
+
+        // The runner owns the jobs once they were added
+        runner.Clear();
+    }
+
+    // Popping all the jobs at once with RunPending(), and running them on the executor
+    void BenchExpiry(const Config& config, std::vector<Result>& results)
+    {
+        Jobs::Runner runner(config.workerCount, config.storeType, config.executorType);
+        runner.Reserve(config.jobCount);
+
+        for (std::size_t i = 0; i < config.jobCount; ++i)
+        {
+            runner.Every(1).Microseconds().Do(&CountFired);
+        }
+
+        // Letting all the jobs expire, and draining them to the job store
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        runner.IdleSeconds();
+
+        g_Fired = 0;
+        Clock::time_point start = Clock::now();
+        runner.RunPending();
+        double dispatchNanoseconds = NanosecondsSince(start);
+
+        bool completed = WaitForFired(config.jobCount, std::chrono::seconds(120));
+        double runNanoseconds = NanosecondsSince(start);
+
+        AddTiming(results, "run_pending_dispatch", config, dispatchNanoseconds, config.jobCount);
+
+        if (completed)
+        {
+            AddTiming(results, "run_pending_complete", config, runNanoseconds, config.jobCount);
+        }
+
+        // NOTE(yuval): The jobs are canceled before they fire again, and destroyed as they complete
+        runner.Clear();
+    }
+
+    // The lag from the scheduled time of a job to the time it starts, with the timer thread running
+    void BenchFireLatency(const Config& config, std::vector<Result>& results)
+    {
+        Jobs::Runner runner(config.workerCount, config.storeType, config.executorType);
+        runner.Reserve(config.jobCount);
+
+        // The probes fire among jobs that wait in the job store
+        std::size_t probeCount = std::min<std::size_t>(config.jobCount, 100);
+        std::vector<Jobs::Job*> probes;
+
+        for (std::size_t i = probeCount; i < config.jobCount; ++i)
+        {
+            runner.Every(1).Hours().Do(&Noop);
+        }
+
+        for (std::size_t i = 0; i < probeCount; ++i)
+        {
+            Jobs::Job& probe = runner.Every(10).Milliseconds().CollectStats();
+            probe.Do(&Noop);
+            probes.push_back(&probe);
+        }
+
+        runner.Run();
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        runner.Stop();
+
+        // Merging the histograms of the probes
+        Jobs::HistogramSnapshot lag = probes.front()->Stats().startLag;
+
+        for (std::size_t i = 1; i < probes.size(); ++i)
+        {
+            Jobs::HistogramSnapshot probeLag = probes[i]->Stats().startLag;
+
+            lag.count += probeLag.count;
+            lag.sum += probeLag.sum;
+            lag.max = std::max(lag.max, probeLag.max);
+
+            for (std::size_t bucket = 0; bucket < Jobs::HistogramSnapshot::BUCKET_COUNT; ++bucket)
+            {
+                lag.buckets[bucket] += probeLag.buckets[bucket];
+            }
+        }
+
+        Result result = MakeResult("fire_latency", config);
+        result.values.emplace_back("runs", static_cast<double>(lag.count));
+        result.values.emplace_back("mean_us", static_cast<double>(lag.Mean().count()));
+        result.values.emplace_back("p50_us", static_cast<double>(lag.Percentile(0.5).count()));
+        result.values.emplace_back("p99_us", static_cast<double>(lag.Percentile(0.99).count()));
+        result.values.emplace_back("max_us", static_cast<double>(lag.max.count()));
+
+        results.push_back(std::move(result));
+        runner.Clear();
+    }
+
+    // Adding, expiring and rescheduling jobs on a ShardedRunner, with a thread per worker adding the jobs
+    void BenchSharded(const Config& config, std::vector<Result>& results)
+    {
+        Jobs::ShardedRunner runner(config.shardCount, config.workerCount, config.storeType, config.executorType);
+        runner.Reserve(config.jobCount);
+
+        // The adding threads contend on the shards' locks, so this is where sharding pays off
+        unsigned int threadCount = std::max(config.workerCount, 1u);
+        std::vector<std::thread> threads;
+        Clock::time_point start = Clock::now();
+
+        for (unsigned int thread = 0; thread < threadCount; ++thread)
+        {
+            std::size_t count = config.jobCount / threadCount + (thread < config.jobCount % threadCount ? 1 : 0);
+
+            threads.emplace_back([&runner, count]()
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    runner.Every(1).Microseconds().Do(&CountFired);
+                }
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        // The first query moves all the added jobs from the shards' inboxes to their job stores
+        runner.IdleSeconds();
+        AddTiming(results, "sharded_add", config, NanosecondsSince(start), config.jobCount);
+
+        // Letting all the jobs expire, and popping them from all the shards at once
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        runner.IdleSeconds();
+
+        g_Fired = 0;
+        start = Clock::now();
+        runner.RunPending();
+
+        if (WaitForFired(config.jobCount, std::chrono::seconds(120)))
+        {
+            AddTiming(results, "sharded_expire", config, NanosecondsSince(start), config.jobCount);
+        }
+
+        // NOTE(yuval): Every run reschedules its job through the shard's inbox, so the jobs only fire again
+        //              once they were rescheduled, and the rounds measure the whole fire and reschedule cycle.
+        const std::uint64_t runCount = 5 * static_cast<std::uint64_t>(config.jobCount);
+        std::uint64_t firstRun = g_Fired.load(std::memory_order_relaxed);
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(120);
+        start = Clock::now();
+
+        while (g_Fired.load(std::memory_order_relaxed) - firstRun < runCount && Clock::now() < deadline)
+        {
+            runner.RunPending();
+        }
+
+        std::uint64_t runs = g_Fired.load(std::memory_order_relaxed) - firstRun;
+        AddTiming(results, "sharded_reschedule", config, NanosecondsSince(start), static_cast<std::size_t>(runs));
+
+        runner.Clear();
+    }
+
+    // Benchmarks of single components that don't depend on the number of jobs
+    void BenchMicro(std::vector<Result>& results)
+    {
+        Config config = { 0, 0, Jobs::JobStoreType::MultiMap, Jobs::ExecutorType::ThreadPool };
+
+        // Calling a job function that captures 48 bytes, compared to std::function
+        {
+            const std::size_t callCount = 10000000;
+            Capture<48> capture = {};
+
+            auto lambda = [capture]() mutable { ++capture.values[0]; };
+            Jobs::JobFunction jobFunc(lambda);
+            std::function<void()> stdFunc(lambda);
+
+            Clock::time_point start = Clock::now();
+
+            for (std::size_t i = 0; i < callCount; ++i)
+            {
+                jobFunc();
+            }
+
+            AddTiming(results, "job_function_invoke", config, NanosecondsSince(start), callCount);
+
+            start = Clock::now();
+
+            for (std::size_t i = 0; i < callCount; ++i)
+            {
+                stdFunc();
+            }
+
+            AddTiming(results, "std_function_invoke", config, NanosecondsSince(start), callCount);
+        }
+
+        // Constructing, moving and invoking a job function, compared to std::function, with a capture that fits
+        // in the job function's buffer and one that doesn't (JOB_FUNCTION_BUFFER_SIZE is 64 bytes by default)
+        {
+            const std::size_t count = 1000000;
+
+            AddTiming(results, "job_function_construct_move_invoke_48b", config,
+                      ConstructMoveInvoke<Jobs::JobFunction, 48>(count), count);
+            AddTiming(results, "std_function_construct_move_invoke_48b", config,
+                      ConstructMoveInvoke<std::function<void()>, 48>(count), count);
+            AddTiming(results, "job_function_construct_move_invoke_96b", config,
+                      ConstructMoveInvoke<Jobs::JobFunction, 96>(count), count);
+            AddTiming(results, "std_function_construct_move_invoke_96b", config,
+                      ConstructMoveInvoke<std::function<void()>, 96>(count), count);
+        }
+
+        // Computing a wall clock next run through the civil time arithmetic
+        {
+            const std::size_t computeCount = 1000000;
+            Jobs::Job job(1);
+            job.Day().At("10:30");
+
+            Clock::time_point start = Clock::now();
+
+            for (std::size_t i = 0; i < computeCount; ++i)
+            {
+                job.GetNextRun();
+            }
+
+            AddTiming(results, "civil_next_run", config, NanosecondsSince(start), computeCount);
+        }
+
+        // Searching the next match of a cron expression
+        {
+            const std::size_t searchCount = 1000000;
+            Jobs::CronSchedule schedule("*/5 9-17 * * 1-5");
+            std::time_t after = std::time(nullptr);
+            std::time_t next;
+
+            Clock::time_point start = Clock::now();
+
+            for (std::size_t i = 0; i < searchCount; ++i)
+            {
+                schedule.Next(after + static_cast<std::time_t>(i * 37), next);
+            }
+
+            AddTiming(results, "cron_next", config, NanosecondsSince(start), searchCount);
+        }
+
+        // The cost of collecting stats per job run, firing the same jobs inline with and without CollectStats()
+        {
+            const std::size_t jobCount = 1000;
+            const std::uint64_t runCount = 1000000;
+            config.jobCount = jobCount;
+            config.workerCount = 1;
+            config.executorType = Jobs::ExecutorType::Inline;
+
+            double nanosecondsPerRun[2] = {};
+
+            for (int collectStats = 0; collectStats < 2; ++collectStats)
+            {
+                Jobs::Runner runner(config.workerCount, config.storeType, config.executorType);
+                runner.Reserve(jobCount);
+
+                for (std::size_t i = 0; i < jobCount; ++i)
+                {
+                    Jobs::Job& job = runner.Every(1).Microseconds();
+
+                    if (collectStats)
+                    {
+                        job.CollectStats();
+                    }
+
+                    job.Do(&CountFired);
+                }
+
+                g_Fired = 0;
+
+                while (g_Fired.load(std::memory_order_relaxed) < 10 * jobCount)
+                {
+                    runner.RunPending();
+                }
+
+                std::uint64_t firstRun = g_Fired.load(std::memory_order_relaxed);
+                Clock::time_point start = Clock::now();
+
+                while (g_Fired.load(std::memory_order_relaxed) - firstRun < runCount)
+                {
+                    runner.RunPending();
+                }
+
+                nanosecondsPerRun[collectStats] = NanosecondsSince(start) / (g_Fired.load() - firstRun);
+                runner.Clear();
+            }
+
+            Result result = MakeResult("stats_overhead", config);
+            result.values.emplace_back("runs", static_cast<double>(runCount));
+            result.values.emplace_back("stats_off_ns_per_run", nanosecondsPerRun[0]);
+            result.values.emplace_back("stats_on_ns_per_run", nanosecondsPerRun[1]);
+            result.values.emplace_back("overhead_ns_per_run", nanosecondsPerRun[1] - nanosecondsPerRun[0]);
+
+            results.push_back(std::move(result));
+        }
+
+        // Allocations per job run once the jobs fired once (see Runner::Reserve)
+        {
+            const std::size_t jobCount = 1000;
+            const std::uint64_t runCount = 1000000;
+            config.jobCount = jobCount;
+            config.workerCount = 4;
+            config.executorType = Jobs::ExecutorType::WorkStealing;
+
+            Jobs::Runner runner(config.workerCount, config.storeType, config.executorType);
+            runner.Reserve(jobCount);
+
+            for (std::size_t i = 0; i < jobCount; ++i)
+            {
+                runner.Every(1).Microseconds().Do(&CountFired);
+            }
+
+            g_Fired = 0;
+
+            while (g_Fired.load(std::memory_order_relaxed) < 10 * jobCount)
+            {
+                runner.RunPending();
+            }
+
+            std::uint64_t firstRun = g_Fired.load(std::memory_order_relaxed);
+            g_AllocationCount = 0;
+            g_CountAllocations = true;
+
+            while (g_Fired.load(std::memory_order_relaxed) - firstRun < runCount)
+            {
+                runner.RunPending();
+            }
+
+            g_CountAllocations = false;
+
+            // The steady state run path must not allocate at all
+            if (g_AllocationCount.load() != 0)
+            {
+                std::cerr << "allocations_per_run: " << g_AllocationCount.load() << " allocations in "
+                          << g_Fired.load() - firstRun << " runs, expected none" << std::endl;
+                g_Failed = true;
+            }
+
+            Result result = MakeResult("allocations_per_run", config);
+            result.values.emplace_back("runs", static_cast<double>(g_Fired.load() - firstRun));
+            result.values.emplace_back("allocations", static_cast<double>(g_AllocationCount.load()));
+            result.values.emplace_back("allocations_per_run",
+                                       static_cast<double>(g_AllocationCount.load()) / (g_Fired.load() - firstRun));
+
+            results.push_back(std::move(result));
+            runner.Clear();
+        }
+    }
+
+    std::vector<std::string> SplitList(const std::string& list)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+            {
+                items.push_back(item);
+            }
+        }
+
+        return items;
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            std::size_t equals = arg.find('=');
+            std::string name = arg.substr(0, equals);
+            std::string value = equals == std::string::npos ? std::string() : arg.substr(equals + 1);
+
+            if (name == "--jobs")
+            {
+                options.jobCounts.clear();
+
+                for (const std::string& item : SplitList(value))
+                {
+                    options.jobCounts.push_back(std::stoull(item));
+                }
+            }
+            else if (name == "--workers")
+            {
+                options.workerCounts.clear();
+
+                for (const std::string& item : SplitList(value))
+                {
+                    options.workerCounts.push_back(static_cast<unsigned int>(std::stoul(item)));
+                }
+            }
+            else if (name == "--stores")
+            {
+                options.storeTypes.clear();
+
+                for (const std::string& item : SplitList(value))
+                {
+                    options.storeTypes.push_back(item == "timing_wheel" ? Jobs::JobStoreType::TimingWheel :
+                                                                          Jobs::JobStoreType::MultiMap);
+                }
+            }
+            else if (name == "--executors")
+            {
+                options.executorTypes.clear();
+
+                for (const std::string& item : SplitList(value))
+                {
+                    options.executorTypes.push_back(item == "work_stealing" ? Jobs::ExecutorType::WorkStealing :
+                                                                              Jobs::ExecutorType::ThreadPool);
+                }
+            }
+            else if (name == "--shards")
+            {
+                options.shardCounts.clear();
+
+                for (const std::string& item : SplitList(value))
+                {
+                    options.shardCounts.push_back(static_cast<unsigned int>(std::stoul(item)));
+                }
+            }
+            else if (name == "--no-micro")
+            {
+                options.runMicro = false;
+            }
+            else if (name == "--output")
+            {
+                options.outputPath = value;
+            }
+            else
+            {
+                std::cerr << "Usage: " << argv[0] << " [--jobs=1000,10000,100000,1000000] [--workers=1,4,16]\n"
+                          << "       [--stores=multimap,timing_wheel] [--executors=thread_pool,work_stealing]\n"
+                          << "       [--shards=1,2,4,8,16,32] [--no-micro] [--output=results.json]\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::string JsonString(const std::string& str)
+    {
+        std::string escaped = "\"";
+
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+            {
+                escaped += '\\';
+            }
+
+            escaped += c;
+        }
+
+        return escaped + "\"";
+    }
+
+    void WriteJson(std::ostream& out, const std::vector<Result>& results)
+    {
+        char timestamp[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        out.precision(10);
+        out << "{\n";
+        out << "  \"library\": \"Jobs\",\n";
+        out << "  \"timestamp\": " << JsonString(timestamp) << ",\n";
+#ifdef __VERSION__
+        out << "  \"compiler\": " << JsonString(__VERSION__) << ",\n";
+#endif
+        out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"results\": [";
+
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& result = results[i];
+
+            out << (i == 0 ? "\n" : ",\n");
+            out << "    {\"benchmark\": " << JsonString(result.benchmark)
+                << ", \"jobs\": " << result.jobCount
+                << ", \"workers\": " << result.workerCount
+                << ", \"store\": " << JsonString(result.storeType)
+                << ", \"executor\": " << JsonString(result.executorType);
+
+            if (result.shardCount != 0)
+            {
+                out << ", \"shards\": " << result.shardCount;
+            }
+
+            for (const std::pair<std::string, double>& value : result.values)
+            {
+                out << ", " << JsonString(value.first) << ": " << value.second;
+            }
+
+            out << "}";
+        }
+
+        out << "\n  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        return 1;
+    }
+
+    std::vector<Result> results;
+
+    if (options.runMicro)
+    {
+        std::cerr << "micro benchmarks" << std::endl;
+        BenchMicro(results);
+    }
+
+    for (Jobs::JobStoreType::Type storeType : options.storeTypes)
+    {
+        for (Jobs::ExecutorType::Type executorType : options.executorTypes)
+        {
+            for (unsigned int workerCount : options.workerCounts)
+            {
+                for (std::size_t jobCount : options.jobCounts)
+                {
+                    Config config = { jobCount, workerCount, storeType, executorType };
+
+                    std::cerr << StoreName(storeType) << ", " << ExecutorName(executorType) << ", "
+                              << workerCount << " workers, " << jobCount << " jobs" << std::endl;
+
+                    BenchRegistration(config, results);
+                    BenchBatchRegistration(config, results);
+                    BenchAddJob(config, results);
+                    BenchExpiry(config, results);
+                    BenchFireLatency(config, results);
+                }
+            }
+
+            // The shard sweep runs with the most workers, so the executor isn't what limits it
+            unsigned int workerCount = *std::max_element(options.workerCounts.begin(), options.workerCounts.end());
+
+            for (std::size_t jobCount : options.jobCounts)
+            {
+                for (unsigned int shardCount : options.shardCounts)
+                {
+                    Config config = { jobCount, workerCount, storeType, executorType, shardCount };
+
+                    std::cerr << StoreName(storeType) << ", " << ExecutorName(executorType) << ", "
+                              << shardCount << " shards, " << jobCount << " jobs" << std::endl;
+
+                    BenchSharded(config, results);
+                }
+            }
+        }
+    }
+
+    if (options.outputPath.empty())
+    {
+        WriteJson(std::cout, results);
+    }
+    else
+    {
+        std::ofstream out(options.outputPath);
+        WriteJson(out, results);
+    }
+
+    return g_Failed ? 1 : 0;
+}
@@ -4,7 +4,10 @@
 /* This generated file contains includes for project dependencies */
 #include "bake_config.h"
 
+#include "Jobs/Coroutine.h"
 #include "Jobs/Default.h"
+#include "Jobs/JobBatch.h"
+#include "Jobs/ShardedRunner.h"
 
 #endif
 
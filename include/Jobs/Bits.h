@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Jobs
+{
+    // Returns the index of the lowest set bit, the word must not be zero
+    inline std::size_t LowestSetBit(std::uint64_t word)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return static_cast<std::size_t>(index);
+#else
+        return static_cast<std::size_t>(__builtin_ctzll(word));
+#endif
+    }
+
+    // Mixes the bits of a word (the splitmix64 finalizer), so close words hash far apart
+    inline std::uint64_t MixBits(std::uint64_t word)
+    {
+        word = (word ^ (word >> 30)) * 0xBF58476D1CE4E5B9ull;
+        word = (word ^ (word >> 27)) * 0x94D049BB133111EBull;
+        return word ^ (word >> 31);
+    }
+
+    // Returns the index of the highest set bit, the word must not be zero
+    inline std::size_t HighestSetBit(std::uint64_t word)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, word);
+        return static_cast<std::size_t>(index);
+#else
+        return static_cast<std::size_t>(63 - __builtin_clzll(word));
+#endif
+    }
+}
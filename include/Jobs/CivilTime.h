@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+namespace Jobs
+{
+    // A broken down date and time.
+    // Fields may be out of their ranges (e.g. day 32) until the time is converted back
+    // with TimeZone::FromCivil, which normalizes them like std::mktime does.
+    struct CivilTime
+    {
+        std::int64_t year;
+        int month; // 1 - 12
+        int day; // 1 - 31
+        int hour; // 0 - 23
+        int minute; // 0 - 59
+        int second; // 0 - 59
+        int weekDay; // 0 - 6, days since Sunday
+    };
+
+    // Returns the number of days since 1970-01-01 of a proleptic Gregorian date
+    std::int64_t DaysFromCivil(std::int64_t year, int month, int day);
+
+    // Converts a number of days since 1970-01-01 to a proleptic Gregorian date
+    void CivilFromDays(std::int64_t days, std::int64_t& year, int& month, int& day);
+
+    // Converts between UTC times and local civil times with plain arithmetic.
+    // The UTC offsets of the process time zone are cached in a table of the transitions
+    // (e.g. DST changes) around the time the table was built, so conversions never
+    // call into libc or take its time zone lock. Times outside the table are
+    // converted with the thread safe libc functions.
+    class TimeZone
+    {
+    public:
+        // Returns the process time zone
+        static const TimeZone& Local();
+
+        // Returns the UTC offset in seconds at the given UTC time
+        int OffsetAt(std::time_t utc) const;
+
+        // Converts a UTC time to the local civil time
+        CivilTime ToCivil(std::time_t utc) const;
+
+        // Converts a local civil time to UTC, normalizing out of range fields
+        // NOTE(yuval): A local time that is skipped by a DST change is shifted forward by the change,
+        //              and a local time that repeats maps to the earlier of its two instants.
+        std::time_t FromCivil(const CivilTime& local) const;
+
+    private:
+        // The UTC offset from a UTC time onward
+        struct Transition
+        {
+            std::time_t utc;
+            int offset;
+        };
+
+        // Builds the transition table of the given time range
+        TimeZone(std::time_t begin, std::time_t end);
+
+        // Asks libc for the UTC offset at the given UTC time
+        static int ProbeOffset(std::time_t utc);
+
+    private:
+        std::vector<Transition> m_Transitions; // Sorted by time, the first one starts the table
+        std::time_t m_End; // The end of the time range the table covers
+    };
+}
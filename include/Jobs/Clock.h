@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Jobs
+{
+    class InterruptableSleeper;
+
+    // The source of time of a runner, its jobs and its timer thread's sleeper
+    class Clock
+    {
+    public:
+        using Duration = std::chrono::steady_clock::duration;
+        using TimePoint = std::chrono::steady_clock::time_point;
+
+        virtual ~Clock() = default;
+
+        // Returns the clock that reads the real time (shared by all the runners that don't get a clock)
+        static const std::shared_ptr<Clock>& System();
+
+        // Returns the current (monotonic) time
+        virtual TimePoint Now() const = 0;
+
+        // Returns the current wall clock time
+        virtual std::time_t WallTime() const = 0;
+
+        // Conversions between wall clock times and the clock's (monotonic) times
+        virtual TimePoint FromTimeT(std::time_t time) const = 0;
+        virtual std::time_t ToTimeT(TimePoint time) const = 0;
+
+        // Returns true if the clock advances on its own, so sleepers can wait for it with a timeout.
+        // Sleepers on other clocks wait until the clock interrupts them.
+        virtual bool IsRealTime() const = 0;
+
+        // Registers a sleeper that the clock interrupts whenever it advances (if it isn't real time)
+        virtual void AddSleeper(InterruptableSleeper* /* sleeper */)
+        {
+        }
+
+        virtual void RemoveSleeper(InterruptableSleeper* /* sleeper */)
+        {
+        }
+    };
+
+    // Reads the real time from std::chrono::steady_clock and std::chrono::system_clock
+    class SystemClock : public Clock
+    {
+    public:
+        TimePoint Now() const override;
+        std::time_t WallTime() const override;
+        TimePoint FromTimeT(std::time_t time) const override;
+        std::time_t ToTimeT(TimePoint time) const override;
+        bool IsRealTime() const override;
+    };
+
+    // A clock that only moves when it is advanced, so schedules can be simulated
+    // as fast as the jobs run (see Runner::AdvanceClock)
+    class VirtualClock : public Clock
+    {
+    public:
+        // Ctor (the clock starts at the given wall clock time)
+        VirtualClock(std::time_t start = std::time(nullptr));
+
+        TimePoint Now() const override;
+        std::time_t WallTime() const override;
+        TimePoint FromTimeT(std::time_t time) const override;
+        std::time_t ToTimeT(TimePoint time) const override;
+        bool IsRealTime() const override;
+        void AddSleeper(InterruptableSleeper* sleeper) override;
+        void RemoveSleeper(InterruptableSleeper* sleeper) override;
+
+        // Moves the clock to the given time (the clock never moves back), and interrupts its sleepers
+        void AdvanceTo(TimePoint time);
+
+        // Moves the clock forward by the given duration, and interrupts its sleepers
+        void AdvanceBy(Duration duration);
+
+    private:
+        TimePoint m_Start; // The time that matches the wall clock start time
+        std::time_t m_WallStart;
+        std::atomic<Duration::rep> m_Now;
+        std::mutex m_SleepersMutex;
+        std::vector<InterruptableSleeper*> m_Sleepers;
+    };
+}
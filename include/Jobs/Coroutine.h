@@ -0,0 +1,339 @@
+#pragma once
+
+#include "Jobs/Job.h"
+#include "Jobs/Runner.h"
+
+// Coroutine jobs need C++20, the rest of the library builds as C++17
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define JOBS_COROUTINES 1
+#endif
+#endif
+
+#ifndef JOBS_COROUTINES
+#define JOBS_COROUTINES 0
+#endif
+
+#if JOBS_COROUTINES
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace Jobs
+{
+    // The return type of a coroutine job function, for example:
+    //     runner.Every(5).Seconds().Do([&runner]() -> Jobs::JobCoroutine
+    //     {
+    //         co_await runner.SleepFor(std::chrono::seconds(1)); // The worker is free while the job sleeps
+    //     });
+    // The job's run completes once the coroutine completes, so the job is only rescheduled then.
+    class JobCoroutine
+    {
+        template <typename F>
+        friend class CoroutineJobFunction;
+
+    // Public Types
+    public:
+        class promise_type
+        {
+            friend class JobCoroutine;
+
+        public:
+            inline JobCoroutine get_return_object() noexcept
+            {
+                return JobCoroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            // NOTE(yuval): The coroutine starts suspended, so its job is known before it runs
+            inline std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            // The coroutine destroys itself and then completes its job's run
+            inline auto final_suspend() noexcept
+            {
+                struct FinalAwaiter
+                {
+                    inline bool await_ready() noexcept
+                    {
+                        return false;
+                    }
+
+                    inline void await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                    {
+                        Job* job = handle.promise().m_Job;
+                        handle.destroy();
+                        JobCoroutine::Completed(job);
+                    }
+
+                    inline void await_resume() noexcept
+                    {
+                    }
+                };
+
+                return FinalAwaiter{};
+            }
+
+            inline void return_void() noexcept
+            {
+            }
+
+            // An exception that escapes the coroutine is counted like one thrown by a job function
+            inline void unhandled_exception() noexcept
+            {
+                JobCoroutine::Threw(m_Job);
+            }
+
+            // Returns the job that runs the coroutine
+            inline Job* GetJob() const noexcept
+            {
+                return m_Job;
+            }
+
+        private:
+            Job* m_Job = nullptr;
+        };
+
+    // Public Methods
+    public:
+        JobCoroutine(JobCoroutine&& other) noexcept
+            : m_Handle(std::exchange(other.m_Handle, nullptr))
+        {
+        }
+
+        // A coroutine that was never started is destroyed with its owner
+        ~JobCoroutine()
+        {
+            if (m_Handle)
+            {
+                m_Handle.destroy();
+            }
+        }
+
+        // No copy constructors for the JobCoroutine
+        JobCoroutine(const JobCoroutine& other) = delete;
+        JobCoroutine& operator=(const JobCoroutine& other) = delete;
+        JobCoroutine& operator=(JobCoroutine&& other) = delete;
+
+    // Private Methods
+    private:
+        explicit JobCoroutine(std::coroutine_handle<promise_type> handle) noexcept
+            : m_Handle(handle)
+        {
+        }
+
+        // Runs the coroutine on behalf of the given job until it first suspends
+        // NOTE(yuval): The coroutine might complete and destroy itself on another worker
+        //              as soon as it suspends, so it is released before it is resumed.
+        inline void Start(Job* job)
+        {
+            std::coroutine_handle<promise_type> handle = std::exchange(m_Handle, nullptr);
+            handle.promise().m_Job = job;
+            handle.resume();
+        }
+
+        static inline void Completed(Job* job)
+        {
+            job->AsyncCompleted();
+        }
+
+        static inline void Threw(Job* job)
+        {
+            job->AsyncThrew();
+        }
+
+    // Private Fields
+    private:
+        std::coroutine_handle<promise_type> m_Handle;
+    };
+
+    template <typename F>
+    class CoroutineJobFunction
+    {
+    public:
+        template <typename Func>
+        CoroutineJobFunction(Func&& func, Job* job)
+            : m_Func(std::forward<Func>(func)), m_Job(job)
+        {
+        }
+
+        inline void operator()()
+        {
+            JobCoroutine coroutine = m_Func();
+            coroutine.Start(m_Job);
+        }
+
+    private:
+        F m_Func;
+        Job* m_Job;
+    };
+
+    // Awaits a JobSleep: the job is suspended and its worker is free until the runner's timer
+    // thread submits it back to the executor once the sleep is over
+    class SleepAwaiter : private Task
+    {
+    public:
+        explicit SleepAwaiter(const JobSleep& sleep)
+            : m_Runner(sleep.runner), m_Duration(sleep.duration)
+        {
+        }
+
+        inline bool await_ready() const noexcept
+        {
+            return m_Duration <= Clock::Duration::zero();
+        }
+
+        // NOTE(yuval): The awaiter must not be touched once it was submitted, since another thread
+        //              might resume the coroutine (and destroy the awaiter) before this returns.
+        inline void await_suspend(std::coroutine_handle<JobCoroutine::promise_type> handle)
+        {
+            m_Handle = handle;
+            m_WakeupTime = m_Runner->GetClock().Now() + m_Duration;
+            m_Runner->SubmitAt(m_WakeupTime, this, handle.promise().GetJob()->GetPriority());
+        }
+
+        // A sleep that ended early was cut short by the destruction of the runner
+        inline void await_resume() const
+        {
+            if (m_Duration > Clock::Duration::zero() && m_Runner->GetClock().Now() < m_WakeupTime)
+            {
+                throw JobException("The Runner Was Destroyed While The Job Slept");
+            }
+        }
+
+    private:
+        void Execute() override
+        {
+            m_Handle.resume();
+        }
+
+    private:
+        Runner* m_Runner;
+        Clock::Duration m_Duration;
+        Clock::TimePoint m_WakeupTime;
+        std::coroutine_handle<> m_Handle;
+    };
+
+    inline SleepAwaiter operator co_await(const JobSleep& sleep)
+    {
+        return SleepAwaiter(sleep);
+    }
+
+    // The state that JobCompletion<T> and JobCompletion<void> share
+    class JobCompletionBase : private Task
+    {
+    public:
+        JobCompletionBase()
+            : m_State(Empty), m_Priority(JobPriority::Normal)
+        {
+        }
+
+        // No copy constructors for the JobCompletion
+        JobCompletionBase(const JobCompletionBase& other) = delete;
+        JobCompletionBase& operator=(const JobCompletionBase& other) = delete;
+
+        inline bool await_ready() const noexcept
+        {
+            return m_State.load(std::memory_order_acquire) == Completed;
+        }
+
+        // Suspends the job until the completion is completed, returns false if it already was
+        inline bool await_suspend(std::coroutine_handle<JobCoroutine::promise_type> handle)
+        {
+            m_Handle = handle;
+            m_Lifetime = handle.promise().GetJob()->Handle().GetRunner()->GetLifetime();
+            m_Priority = handle.promise().GetJob()->GetPriority();
+
+            int expected = Empty;
+            return m_State.compare_exchange_strong(expected, Waiting, std::memory_order_acq_rel);
+        }
+
+    protected:
+        // Resumes the job that waits for the completion on its runner's executor lane.
+        // If the runner was already destroyed the job is never resumed (and its coroutine is leaked),
+        // so the pending completions should be completed before their runner is destroyed.
+        // NOTE(yuval): The completion lives in the coroutine, so it must not be touched once
+        //              the coroutine was submitted.
+        inline void Complete()
+        {
+            if (m_State.exchange(Completed, std::memory_order_acq_rel) != Waiting)
+            {
+                return;
+            }
+
+            std::shared_ptr<RunnerLifetime> lifetime = std::move(m_Lifetime);
+            Runner* runner = lifetime->Acquire();
+
+            if (runner != nullptr)
+            {
+                runner->Submit(this, m_Priority);
+                lifetime->Release();
+            }
+        }
+
+    private:
+        enum State
+        {
+            Empty = 0, // Neither awaited nor completed
+            Waiting, // A job waits for the completion
+            Completed
+        };
+
+        void Execute() override
+        {
+            m_Handle.resume();
+        }
+
+    private:
+        std::atomic<int> m_State;
+        std::shared_ptr<RunnerLifetime> m_Lifetime; // The lifetime of the runner of the job that waits
+        JobPriority::Class m_Priority;
+        std::coroutine_handle<> m_Handle;
+    };
+
+    // An event that a coroutine job awaits until another thread completes it (with a value),
+    // for example from the callback of an asynchronous operation:
+    //     Jobs::JobCompletion<std::size_t> read;
+    //     AsyncRead(socket, buffer, [&read](std::size_t size) { read.Complete(size); });
+    //     std::size_t size = co_await read; // The worker is free until the read completes
+    // The job is resumed on its runner's executor, not on the thread that completed the event.
+    template <typename T = void>
+    class JobCompletion : public JobCompletionBase
+    {
+    public:
+        inline void Complete(T value)
+        {
+            m_Value.emplace(std::move(value));
+            JobCompletionBase::Complete();
+        }
+
+        inline T await_resume()
+        {
+            return std::move(*m_Value);
+        }
+
+    private:
+        std::optional<T> m_Value;
+    };
+
+    template <>
+    class JobCompletion<void> : public JobCompletionBase
+    {
+    public:
+        inline void Complete()
+        {
+            JobCompletionBase::Complete();
+        }
+
+        inline void await_resume() noexcept
+        {
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace Jobs
+{
+    // A cron expression compiled to a bitmask per field.
+    // Expressions have 5 fields ("minute hour day-of-month month day-of-week")
+    // or 6 fields (with a leading second field). Every field is a list of
+    // "*", "N", "N-M", "*/S", "N/S" or "N-M/S" items, months and week days
+    // can also be given by their 3 letter English names.
+    // Like cron, a day matches if either of the day fields matches when both are restricted
+    // (neither starts with "*"), and only if both match otherwise.
+    class CronSchedule
+    {
+    public:
+        // Compiles the expression, throws a JobException if it is invalid
+        CronSchedule(const std::string& expression);
+
+        // Sets next to the first matching time after the given UTC time,
+        // returns false if the schedule never matches
+        bool Next(std::time_t after, std::time_t& next) const;
+
+    private:
+        // Parses a comma separated field to a bitmask of the values in [min, max]
+        static std::uint64_t ParseField(const std::string& field, int min, int max, const char* const* names);
+
+        // Parses a single value of a field
+        static int ParseValue(const std::string& value, int min, const char* const* names);
+
+        // Returns the mask of the days in the given month that match the day fields
+        std::uint32_t DayMask(std::int64_t year, int month) const;
+
+    private:
+        std::uint64_t m_Seconds; // Bits 0 - 59
+        std::uint64_t m_Minutes; // Bits 0 - 59
+        std::uint32_t m_Hours; // Bits 0 - 23
+        std::uint32_t m_DaysOfMonth; // Bits 1 - 31
+        std::uint16_t m_Months; // Bits 1 - 12
+        std::uint8_t m_DaysOfWeek; // Bits 0 - 6 (Sunday is 0)
+        bool m_DaysOfMonthRestricted; // The day-of-month field doesn't start with "*"
+        bool m_DaysOfWeekRestricted; // The day-of-week field doesn't start with "*"
+    };
+}
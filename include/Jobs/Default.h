@@ -12,7 +12,11 @@ namespace Jobs
     void RunAll();
     void Clear();
     void CancelJob(Job* job);
+    bool CancelJob(const JobHandle& handle);
     Job* FindJob(const JOB_FUNC_TYPE& fn);
+    Job* FindJob(const std::string& name);
+    std::vector<JobHandle> FindByTag(const std::string& tag);
+    std::size_t CancelByTag(const std::string& tag);
     std::string NextRun();
     int IdleSeconds();
 }
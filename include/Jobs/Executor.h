@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Jobs
+{
+    // A unit of work that runs on an executor
+    class Task
+    {
+    public:
+        virtual ~Task() = default;
+
+        // Runs the task
+        virtual void Execute() = 0;
+    };
+
+    namespace ExecutorType
+    {
+        enum Type
+        {
+            ThreadPool = 0, // A ctpl thread pool with a single shared queue
+            WorkStealing, // Per-worker deques with randomized stealing
+            Inline // Runs the tasks on the thread that submits them
+        };
+    }
+
+    namespace JobPriority
+    {
+        // The priority class of a job, a runner can run every class on an executor lane of its own
+        enum Class : std::uint8_t
+        {
+            Realtime = 0, // Latency critical jobs, dispatched before the others
+            Normal, // (default)
+            Bulk // Heavy jobs that can wait
+        };
+
+        constexpr std::size_t COUNT = 3;
+    }
+
+    // Runs the tasks the Runner dispatches.
+    // Implement this interface to run jobs on an executor of your own.
+    class Executor
+    {
+    public:
+        virtual ~Executor() = default;
+
+        // Creates an executor of the given type
+        static std::shared_ptr<Executor> Create(ExecutorType::Type type, unsigned int workerCount);
+
+        // Queues a task to run on one of the executor's workers.
+        // The task object must stay alive until it runs.
+        virtual void Submit(Task* task) = 0;
+
+        // Waits for all the queued tasks (including the tasks they submit) to run,
+        // and stops the executor's workers
+        virtual void Shutdown() = 0;
+
+        // Returns the number of workers
+        virtual unsigned int WorkerCount() const = 0;
+
+        // Allocates room for the given number of queued tasks up front, so an executor
+        // that supports it doesn't allocate when tasks are submitted
+        virtual void Reserve(std::size_t /* taskCount */)
+        {
+        }
+
+        // Returns the number of tasks that were submitted but didn't start running yet
+        // (executors that don't track it return 0)
+        virtual std::size_t QueuedTaskCount() const
+        {
+            return 0;
+        }
+
+        // Returns the number of workers that are running a task
+        // (executors that don't track it return 0)
+        virtual unsigned int BusyWorkerCount() const
+        {
+            return 0;
+        }
+    };
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Jobs/Executor.h"
+
+namespace Jobs
+{
+    // Runs every task on the thread that submits it, before Submit returns.
+    // Together with a VirtualClock this makes a runner fully deterministic.
+    // NOTE(yuval): The tasks run on the runner's timer thread (or on the thread that calls RunPending),
+    //              so a job that calls RunPending or RunAll from its job function deadlocks.
+    class InlineExecutor : public Executor
+    {
+    public:
+        void Submit(Task* task) override;
+        void Shutdown() override;
+        unsigned int WorkerCount() const override;
+    };
+}
@@ -1,20 +1,30 @@
 #pragma once
 
+#include "Jobs/Clock.h"
 #include <chrono>
 #include <condition_variable>
-#include <ctime>
 #include <mutex>
 #include <thread>
 
+// On Linux the sleeper waits on a timerfd and an eventfd, which an event loop can poll as well
+#if defined(__linux__)
+#define JOBS_POLL_FD 1
+#else
+#define JOBS_POLL_FD 0
+#endif
+
 namespace Jobs
 {
+    // Sleeps until a given time or until another thread interrupts it.
+    // NOTE(yuval): On Linux a timerfd that is armed with the absolute deadline and an eventfd for the interrupts
+    //              are watched by an epoll fd, so interrupting the sleeper is a single write that doesn't take
+    //              a lock, and an event loop can poll the sleeper (see GetPollFd). The sleeper falls back to a
+    //              condition variable elsewhere, or if the file descriptors can't be created.
     class InterruptableSleeper
     {
-        using Clock = std::chrono::system_clock;
-
     public:
-        // Ctor, Dtor
-        InterruptableSleeper();
+        // Ctor, Dtor (the sleeper sleeps on the given clock, the clock must outlive it)
+        InterruptableSleeper(Clock* clock = Clock::System().get());
         ~InterruptableSleeper();
 
         // No copy constructors for the InterruptableSleeper
@@ -26,11 +36,12 @@ namespace Jobs
         InterruptableSleeper& operator=(InterruptableSleeper&& other) noexcept = delete;
 
         // Sleep for a given durtaion
-        void SleepFor(Clock::duration duration);
+        void SleepFor(Clock::Duration duration);
 
         // Sleep until a given time
-        void SleepUntil(std::time_t time);
-        void SleepUntil(Clock::time_point time);
+        // NOTE(yuval): On a clock that isn't real time, the sleeper sleeps until the clock
+        //              advances past the given time, or until it gets interrupted.
+        void SleepUntil(Clock::TimePoint time);
 
         // Just sleep...
         void Sleep();
@@ -38,10 +49,38 @@ namespace Jobs
         // Interrupt the sleeper
         void Interrupt();
 
+        // Event Loop Polling
+        // Returns a file descriptor that becomes readable once the sleeper is interrupted or its timer expires
+        // (-1 if the sleeper has none)
+        inline int GetPollFd() const
+        {
+            return m_PollFd;
+        }
+
+        // Arms the timer to expire at the given time, replacing the previous time
+        // NOTE(yuval): On a clock that isn't real time the timer is disarmed, the clock interrupts the sleeper instead.
+        void Arm(Clock::TimePoint time);
+
+        // Disarms the timer
+        void Disarm();
+
+        // Clears the poll fd's readiness, returns true if the sleeper was interrupted or its timer expired
+        bool Consume();
+
     private:
+        // Waits until the poll fd is readable
+        void Wait();
+
+        // Closes the file descriptors, so the sleeper falls back to the condition variable
+        void ClosePollFd();
+
+    private:
+        Clock* m_Clock;
         bool m_Interrupted;
         std::mutex m_Mutex;
         std::condition_variable m_CV;
+        int m_PollFd; // An epoll fd that watches m_TimerFd and m_EventFd
+        int m_TimerFd;
+        int m_EventFd;
     };
 }
-
@@ -1,13 +1,25 @@
 #pragma once
 
+#include "Jobs/Clock.h"
+#include "Jobs/Executor.h"
+#include "Jobs/JobFunction.h"
+#include "Jobs/JobHandle.h"
+#include "Jobs/JobStats.h"
+#include "Jobs/ScheduleSnapshot.h"
+#include <chrono>
+#include <cstdint>
 #include <ctime>
 #include <exception>
 #include <functional>
-#include <random>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-#define JOB_FUNC_TYPE std::function<void(void)>
+#define JOB_FUNC_TYPE Jobs::JobFunction
+#define JOB_CLOCK_TYPE std::chrono::steady_clock
+#define JOB_TIME_TYPE JOB_CLOCK_TYPE::time_point
 
 #define BIND_FN(fn) std::bind(&fn)
 #define BIND_METHOD(method, obj) std::bind(&method, obj)
@@ -15,16 +27,38 @@
 namespace Jobs
 {
     class Runner;
+    class JobCoroutine;
+    class JobGraph;
+    struct CivilTime;
+
+    // Starts the coroutine of a coroutine job (defined in Jobs/Coroutine.h)
+    template <typename F>
+    class CoroutineJobFunction;
 
     namespace JobUnit
     {
-        enum Unit
+        enum Unit : std::uint8_t
         {
             Seconds = 0,
             Minutes,
             Hours,
             Days,
-            Weeks
+            Weeks,
+            Milliseconds,
+            Microseconds
+        };
+    }
+
+    namespace OverlapPolicy
+    {
+        // What happens to a run that comes due while the job's previous run is still executing
+        enum Policy : std::uint8_t
+        {
+            None = 0, // The job is only rescheduled once its run completes, so its runs never overlap (default)
+            Skip, // The run is skipped
+            Coalesce, // The runs are coalesced into one run that starts once the previous run completes
+            Queue, // Up to limit runs wait for the previous run, and run one after another
+            Concurrent // Up to limit runs execute concurrently
         };
     }
 
@@ -52,8 +86,13 @@ namespace Jobs
         std::string m_Msg;
     };
 
-    class Job
+    class Job : public Task
     {
+        friend class Runner;
+        friend class JobBatch;
+        friend class JobCoroutine;
+        friend class JobGraph;
+
     // Public Methods
     public:
         // Ctor, Dtor
@@ -66,6 +105,20 @@ namespace Jobs
             return m_JobFunc;
         }
 
+        // Returns the handle the job's runner assigned to it
+        inline const JobHandle& Handle() const
+        {
+            return m_Handle;
+        }
+
+        // Microseconds
+        Job& Microsecond();
+        Job& Microseconds();
+
+        // Milliseconds
+        Job& Millisecond();
+        Job& Milliseconds();
+
         // Seconds
         Job& Second();
         Job& Seconds();
@@ -102,52 +155,240 @@ namespace Jobs
         // Schedules the job to run in a random time in range: from 'every' to 'latests'
         Job& To(int latest);
 
-        // Specifies the function that will be called every time the job runs
-        Job& Do(const JOB_FUNC_TYPE& jobFunc);
+        // Runs the job on a cron schedule instead of its interval, for example
+        // "*/5 9-17 * * 1-5" (every 5 minutes from 09:00 to 17:55 on week days)
+        Job& Cron(const std::string& expression);
+
+        // Makes the job collect execution statistics (must be called before Do)
+        // NOTE(yuval): The statistics take about 1.6KB per job, so they are only collected on demand.
+        Job& CollectStats();
+
+        // Returns a copy of the job's execution statistics (all zeros if it doesn't collect them)
+        JobStatsSnapshot Stats() const;
+
+        // Sets the job's priority class, which picks the executor lane it runs on (must be called before Do)
+        Job& Priority(JobPriority::Class priority);
+
+        // Returns the job's priority class
+        inline JobPriority::Class GetPriority() const
+        {
+            return m_Priority;
+        }
+
+        // Sets what happens to runs that come due while the job is still running (must be called before Do).
+        // A job with an overlap policy other than None is rescheduled when it is dispatched instead of when
+        // its run completes, so it keeps its schedule however long its runs take.
+        Job& Overlap(OverlapPolicy::Policy policy, unsigned int limit = 1);
+
+        // Gives the job a stable (non-zero) id, so its schedule can be saved with Runner::SaveSchedule
+        // and restored after a restart with Runner::RestoreSchedule (must be called before Do)
+        Job& Id(std::uint64_t id);
+
+        // Returns the job's id (0 if it has none)
+        std::uint64_t GetId() const;
+
+        // Gives the job a name that the runner indexes, so FindJob(name) finds it in constant time
+        // (must be called before Do)
+        Job& Name(const std::string& name);
+
+        // Adds a tag that the runner indexes, so FindByTag and CancelByTag find the job without scanning
+        // the other jobs, for example the tenant the job belongs to (must be called before Do)
+        Job& Tag(const std::string& tag);
+
+        // Returns the job's name (an empty string if it has none)
+        const std::string& GetName() const;
+
+        // Returns the job's tags
+        const std::vector<std::string>& GetTags() const;
+
+        // Makes the job run after the upstream job, instead of on a schedule of its own: every time a job
+        // without upstream jobs (the root of their graph) runs, the jobs downstream of it run on the runner
+        // as soon as all of their upstream jobs completed (must be called before Do of either job).
+        // A job that runs after other jobs belongs to its graph: Do returns an empty handle for it,
+        // and it is destroyed along with the graph's roots.
+        Job& After(Job& upstream);
+
+        // Makes the downstream job run after this job (see After), returns the downstream job,
+        // so a chain of jobs can be written as extract.Then(transform).Then(load)
+        Job& Then(Job& downstream);
+
+        // Lets up to limit iterations of the job's graph run at once (1 by default), so the next run of a
+        // root starts while the tail of its previous iteration still runs (must be called before Do).
+        // A run of a root that comes due while the graph has limit iterations in flight is skipped.
+        Job& MaxIterations(unsigned int limit);
+
+        // Specifies the function that will be called every time the job runs,
+        // returns a handle that can be used to cancel the job
+        JobHandle Do(JOB_FUNC_TYPE&& jobFunc);
+
+        // Specifies any void() callable (including move-only ones) as the job function.
+        // A callable that returns a JobCoroutine (see Jobs/Coroutine.h) makes a coroutine job,
+        // whose run completes (and is rescheduled) once its coroutine completes.
+        template <typename F>
+        inline JobHandle Do(F&& jobFunc)
+        {
+            using Func = typename std::decay<F>::type;
+
+            if constexpr (std::is_same<typename std::invoke_result<Func&>::type, JobCoroutine>::value)
+            {
+                MarkAsync();
+                return Do(JOB_FUNC_TYPE(CoroutineJobFunction<Func>(std::forward<F>(jobFunc), this)));
+            }
+            else
+            {
+                return Do(JOB_FUNC_TYPE(std::forward<F>(jobFunc)));
+            }
+        }
 
         // Runs the job
         void Run();
 
-        // Returns the next job run time
-        std::time_t GetNextRun();
+        // Computes and returns the next job run time
+        JOB_TIME_TYPE GetNextRun();
 
-        // Changes the job's interval
+        // Changes the job's interval, throws a JobException if it isn't positive
         void RunEvery(int interval);
 
+        // Conversions between wall clock times and job (monotonic) times of the system clock
+        static JOB_TIME_TYPE FromTimeT(std::time_t time);
+        static std::time_t ToTimeT(JOB_TIME_TYPE time);
+
+    // Private Types
+    private:
+        // The state of rarely used features, allocated the first time one of them is used
+        struct Extension;
+
+        // What the runner does with a run of a job with an overlap policy that came due
+        enum RunAdmission : std::uint8_t
+        {
+            AdmitRun = 0, // Dispatch it
+            AdmitQueued, // It runs once the job's previous run completes
+            AdmitCoalesced, // It was merged into the job's pending run (or became it, under Coalesce)
+            AdmitSkipped // Drop it
+        };
+
+        // A time of day that is stored inline in the job
+        struct TimeOfDay
+        {
+            std::uint8_t hour;
+            std::uint8_t minute;
+            std::uint8_t second;
+            bool isSet;
+        };
+
     // Private Methods
     private:
+        // Runs the job on the runner's executor, and then hands it back to the runner
+        void Execute() override;
+
+        // Allocates the statistics of a job that collects them
+        // NOTE(yuval): Called before the job is added, so Stats() never races with the allocation.
+        void AllocateStats();
+
+        // Called by the runner right before the job is handed to the executor
+        void Dispatched(JOB_TIME_TYPE now);
+
+        // Records the run that started at the given time and hands the job back to the runner
+        void Complete(JOB_TIME_TYPE startTime, bool threw);
+
+        // Overlapping Runs
+        // NOTE(yuval): A job with an overlap policy stays in the job store while it runs. A lock-free state
+        //              word counts its running and pending runs, so its runs complete without the runner's lock.
+        bool HasOverlapPolicy() const;
+
+        // Decides what happens to a run that came due (called by the runner with its lock held)
+        RunAdmission Admit();
+
+        // Marks a job that was removed from the job store as canceled, returns false if it still has
+        // runs in flight, the last of which hands the job back to the runner once it completes
+        bool RetireOverlapping();
+
+        // Starts the job's next pending run, or hands the job back to the runner if it was canceled
+        void CompleteOverlapping();
+
+        // Coroutine Jobs
+        // NOTE(yuval): The run of a coroutine job completes either in Execute, if its coroutine completed
+        //              before Execute returned, or in AsyncCompleted once its coroutine completes.
+        void MarkAsync();
+        void AsyncThrew();
+        void AsyncCompleted();
+
+        // Schedule Snapshots
+        // Fills the record with the job's schedule (the job must have an id, m_Mutex must be locked)
+        void ToRecord(ScheduleRecord& record, const SnapshotTimeBase& base) const;
+
+        // Returns true if the record holds the job's schedule, so the job can resume it
+        bool MatchesRecord(const ScheduleRecord& record) const;
+
+        // Resumes the schedule the record holds and returns the job's next run time
+        JOB_TIME_TYPE Restore(const ScheduleRecord& record, const SnapshotTimeBase& base,
+                              CatchUpPolicy::Policy catchUp, JOB_TIME_TYPE now);
+
+        // Job Graphs
+        // Returns the job's graph (nullptr if it has none)
+        JobGraph* Graph() const;
+        std::shared_ptr<JobGraph> SharedGraph() const;
+
+        // Returns the job's index in its graph
+        std::uint32_t GraphIndex() const;
+
+        // Makes the job a member of the graph at the given index
+        void JoinGraph(std::shared_ptr<JobGraph> graph, std::uint32_t index);
+
+        // Runs a job of a graph's iteration and records its statistics, returns false if it threw
+        bool RunDownstream();
+
+        // Returns the clock of the job's runner (the system clock if the job has no runner)
+        Clock& JobClock() const;
+
+        // Returns the offset that the runner's dispersion shifts the job by
+        JOB_CLOCK_TYPE::duration DispersionOffset() const;
+
+        // Returns the extension, allocating it on first use
+        Extension& Ext();
+
+        // Computes and returns the next job run time, given the current time
+        JOB_TIME_TYPE GetNextRun(JOB_TIME_TYPE now);
+
         // Computes the instant when this job should run next
-        std::time_t CalcNextRun(int interval) const;
+        JOB_TIME_TYPE CalcNextRun(int interval, JOB_TIME_TYPE now) const;
+
+        // Computes the next run of a wall clock schedule (At() and week days), given the wall clock time
+        std::time_t CalcNextWallRun(int interval, std::time_t now) const;
+
+        // Returns the duration of a single interval unit
+        JOB_CLOCK_TYPE::duration UnitDuration() const;
 
         // Date Time Adjustment Functions
-        void AdjustSeconds(int interval, tm* nextRun) const;
-        void AdjustMinutes(int interval, tm* nextRun) const;
-        void AdjustHours(int interval, tm* nextRun) const;
-        void AdjustDays(int interval, tm* nextRun) const;
-        void AdjustWeeks(int interval, tm* nextRun) const;
-
-        void AtTime(tm* nextRun) const;
-        void AtSecond(tm* nextRun) const;
-        void AtMinute(tm* nextRun) const;
-        void AtHour(tm* nextRun) const;
-
-        static std::tm* GetLocalTime();
+        void AdjustSeconds(int interval, CivilTime* nextRun) const;
+        void AdjustMinutes(int interval, CivilTime* nextRun) const;
+        void AdjustHours(int interval, CivilTime* nextRun) const;
+        void AdjustDays(int interval, CivilTime* nextRun) const;
+        void AdjustWeeks(int interval, CivilTime* nextRun) const;
+
+        void AtTime(CivilTime* nextRun) const;
+        void AtSecond(CivilTime* nextRun) const;
+        void AtMinute(CivilTime* nextRun) const;
+        void AtHour(CivilTime* nextRun) const;
+
         static std::vector<std::string> SplitString(const std::string& str, char delim = ' ');
 
     // Private Fields
     private:
+        // NOTE(yuval): The fields are ordered so they pack tightly, Job.cpp asserts that a job
+        //              stays within 64 bytes besides its job function.
         int m_Interval; // Pause interval * unit between runs
         int m_Latest; // Upper limit to the random interval
-        int m_StartDay; // Day of week on which to start running the job
-        std::tm* m_AtTime; // Optional time at which the job runs
-        std::tm* m_LastRun; // Date and time of the last run
-        JOB_FUNC_TYPE m_JobFunc; // The job function to run
+        TimeOfDay m_AtTime; // Optional time at which the job runs
+        std::int8_t m_StartDay; // Day of week on which to start running the job
         JobUnit::Unit m_Unit; // Time units, e.g. Minutes, Seconds, etc...
-        Runner* m_Runner; // The job runner
-
-        // Random Ints
-        std::random_device m_Rd;
-        std::mt19937 m_Gen;
+        bool m_Pooled; // The job lives in its runner's job pool
+        JobPriority::Class m_Priority; // The executor lane the job runs on
+        JOB_TIME_TYPE m_NextRun; // The time the job is scheduled to run at
+        JOB_FUNC_TYPE m_JobFunc; // The job function to run
+        JobHandle m_Handle; // The job's runner, and its slot once the runner registered it
+        Job* m_InboxNext; // The next job in the runner's inbox
+        Extension* m_Ext; // Optional features (nullptr if none is used)
     };
 }
 
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Jobs/Job.h"
+#include "Jobs/JobHandle.h"
+#include <cstddef>
+#include <vector>
+
+namespace Jobs
+{
+    class Runner;
+
+    // Collects jobs and adds them to a runner at once, for example:
+    //     Jobs::JobBatch batch(runner);
+    //     for (Tenant& tenant : tenants)
+    //     {
+    //         batch.Every(5).Minutes().Do([&tenant] { tenant.Sync(); }); // Not added yet
+    //     }
+    //     std::vector<Jobs::JobHandle> handles = batch.Commit();
+    // The jobs' Do returns an empty handle, since they are only added by Commit (see Runner::AddJobs).
+    class JobBatch
+    {
+    public:
+        // Ctor, Dtor
+        explicit JobBatch(Runner& runner);
+        ~JobBatch();
+
+        // No copy constructors for the JobBatch
+        JobBatch(const JobBatch& other) = delete;
+        JobBatch& operator=(const JobBatch& other) = delete;
+
+        // Schedules a new job in the batch
+        Job& Every(int interval = 1);
+
+        // Returns the number of jobs in the batch
+        inline std::size_t Size() const
+        {
+            return m_Jobs.size();
+        }
+
+        // Adds the batch's jobs to the runner, and returns their handles in the order the jobs were created.
+        // Throws a JobException if a job has no job function.
+        std::vector<JobHandle> Commit();
+
+    private:
+        // Destroys the jobs that weren't committed, and returns their storage to the runner's job pool
+        void Discard();
+
+    private:
+        Runner& m_Runner;
+        std::vector<Job*> m_Jobs;
+        std::vector<void*> m_Storage; // Job storage that was allocated from the runner's job pool ahead of time
+    };
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// The size of the buffer a JobFunction stores its callable in without allocating
+#ifndef JOB_FUNCTION_BUFFER_SIZE
+#define JOB_FUNCTION_BUFFER_SIZE 64
+#endif
+
+namespace Jobs
+{
+    // A move-only void() callable with an inline buffer.
+    // Callables that fit in the buffer (and can be moved without throwing) are stored inline,
+    // larger ones are stored on the heap. Unlike std::function, move-only callables
+    // (e.g. lambdas that capture a std::unique_ptr) can be stored.
+    class JobFunction
+    {
+    public:
+        JobFunction() noexcept
+            : m_Ops(nullptr)
+        {
+        }
+
+        JobFunction(std::nullptr_t) noexcept
+            : m_Ops(nullptr)
+        {
+        }
+
+        // NOTE(yuval): Only callables convert to a JobFunction, so overloads that take a name don't clash
+        template <typename F, typename Callable = typename std::decay<F>::type,
+                  typename = typename std::enable_if<!std::is_same<Callable, JobFunction>::value &&
+                                                     std::is_invocable<Callable&>::value>::type>
+        JobFunction(F&& fn)
+            : m_Ops(nullptr)
+        {
+            Store<Callable>(std::forward<F>(fn), std::integral_constant<bool, FitsInline<Callable>()>());
+        }
+
+        JobFunction(JobFunction&& other) noexcept
+            : m_Ops(other.m_Ops)
+        {
+            if (m_Ops != nullptr)
+            {
+                m_Ops->move(m_Buffer, other.m_Buffer);
+                other.m_Ops = nullptr;
+            }
+        }
+
+        JobFunction& operator=(JobFunction&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+
+                if (other.m_Ops != nullptr)
+                {
+                    other.m_Ops->move(m_Buffer, other.m_Buffer);
+                    m_Ops = other.m_Ops;
+                    other.m_Ops = nullptr;
+                }
+            }
+
+            return *this;
+        }
+
+        ~JobFunction()
+        {
+            Reset();
+        }
+
+        // No copy constructors for the JobFunction
+        JobFunction(const JobFunction& other) = delete;
+        JobFunction& operator=(const JobFunction& other) = delete;
+
+        // Calls the stored callable
+        inline void operator()() const
+        {
+            m_Ops->invoke(m_Buffer);
+        }
+
+        // Returns true if a callable is stored
+        inline explicit operator bool() const
+        {
+            return m_Ops != nullptr;
+        }
+
+        // Returns true if both functions store the same function pointer.
+        // Other callables (like lambdas) have no identity, so they never match.
+        inline bool SameTarget(const JobFunction& other) const
+        {
+            return m_Ops != nullptr && m_Ops == other.m_Ops && m_Ops->equal(m_Buffer, other.m_Buffer);
+        }
+
+        // Destroys the stored callable
+        void Reset() noexcept
+        {
+            if (m_Ops != nullptr)
+            {
+                m_Ops->destroy(m_Buffer);
+                m_Ops = nullptr;
+            }
+        }
+
+    private:
+        // The operations on a stored callable type
+        struct Ops
+        {
+            void (*invoke)(void* buffer);
+            void (*move)(void* to, void* from); // Moves the callable and destroys the moved from one
+            void (*destroy)(void* buffer);
+            bool (*equal)(const void* first, const void* second); // Compares the stored function pointers
+        };
+
+        template <typename Callable>
+        static constexpr bool FitsInline()
+        {
+            return sizeof(Callable) <= JOB_FUNCTION_BUFFER_SIZE &&
+                   alignof(Callable) <= alignof(std::max_align_t) &&
+                   std::is_nothrow_move_constructible<Callable>::value;
+        }
+
+        template <typename Callable>
+        struct InlineOps
+        {
+            static void Invoke(void* buffer)
+            {
+                (*static_cast<Callable*>(buffer))();
+            }
+
+            static void Move(void* to, void* from)
+            {
+                new (to) Callable(std::move(*static_cast<Callable*>(from)));
+                static_cast<Callable*>(from)->~Callable();
+            }
+
+            static void Destroy(void* buffer)
+            {
+                static_cast<Callable*>(buffer)->~Callable();
+            }
+
+            static bool Equal(const void* first, const void* second)
+            {
+                if constexpr (std::is_pointer<Callable>::value)
+                {
+                    return *static_cast<const Callable*>(first) == *static_cast<const Callable*>(second);
+                }
+                else
+                {
+                    return false;
+                }
+            }
+
+            static constexpr Ops OPS = { &Invoke, &Move, &Destroy, &Equal };
+        };
+
+        template <typename Callable>
+        struct HeapOps
+        {
+            static void Invoke(void* buffer)
+            {
+                (**static_cast<Callable**>(buffer))();
+            }
+
+            static void Move(void* to, void* from)
+            {
+                *static_cast<Callable**>(to) = *static_cast<Callable**>(from);
+            }
+
+            static void Destroy(void* buffer)
+            {
+                delete *static_cast<Callable**>(buffer);
+            }
+
+            // NOTE(yuval): Function pointers are always stored inline
+            static bool Equal(const void*, const void*)
+            {
+                return false;
+            }
+
+            static constexpr Ops OPS = { &Invoke, &Move, &Destroy, &Equal };
+        };
+
+        template <typename Callable, typename F>
+        void Store(F&& fn, std::true_type /* fitsInline */)
+        {
+            new (m_Buffer) Callable(std::forward<F>(fn));
+            m_Ops = &InlineOps<Callable>::OPS;
+        }
+
+        template <typename Callable, typename F>
+        void Store(F&& fn, std::false_type /* fitsInline */)
+        {
+            *reinterpret_cast<Callable**>(m_Buffer) = new Callable(std::forward<F>(fn));
+            m_Ops = &HeapOps<Callable>::OPS;
+        }
+
+    private:
+        alignas(std::max_align_t) mutable unsigned char m_Buffer[JOB_FUNCTION_BUFFER_SIZE];
+        const Ops* m_Ops;
+    };
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Jobs/Executor.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Jobs
+{
+    class Job;
+    class Runner;
+
+    // The jobs that Job::After and Job::Then chained into a directed acyclic graph.
+    // A job without upstream jobs is a root: it runs on its own schedule, and every run of it starts an
+    // iteration of the graph, in which each job reachable from the root runs on the root's runner as soon
+    // as all of its upstream jobs (that are reachable from the root) completed.
+    // The other jobs only run in iterations, they belong to the graph and are destroyed with its last root.
+    class JobGraph
+    {
+    public:
+        // Ctor
+        JobGraph();
+
+        // No copy constructors for the JobGraph
+        JobGraph(const JobGraph& other) = delete;
+        JobGraph& operator=(const JobGraph& other) = delete;
+
+        // Makes the downstream job run after the upstream job, merging their graphs,
+        // throws a JobException if the edge closes a cycle
+        static void Connect(Job& upstream, Job& downstream);
+
+        // Returns the graph of the job, creating a graph of its own if it has none
+        static JobGraph& Of(Job& job);
+
+        // Sets the number of iterations that can be in flight at once
+        void MaxIterations(unsigned int limit);
+
+        // Returns the number of iterations that can be in flight at once
+        inline std::uint32_t GetMaxIterations() const
+        {
+            return m_MaxIterations;
+        }
+
+        // Returns true if the job at the given index runs after other jobs
+        bool HasUpstream(std::uint32_t index) const;
+
+        // Reserves an iteration for a run of a root that came due,
+        // returns false if the graph has as many iterations in flight as it allows
+        bool BeginIteration();
+
+        // Runs the jobs downstream of the root, once the root's run (that reserved an iteration) completed.
+        // The jobs downstream of a run that threw are skipped.
+        void StartIteration(Job* root, bool threw);
+
+        // Marks a root that is being destroyed (called by the runner with its lock held), returns false if it
+        // is the graph's last root and iterations are still in flight, the last of which hands it back to the runner
+        bool RetireRoot(Job* root);
+
+        // Returns true once all of the graph's roots were retired
+        bool Retired() const;
+
+        // Returns the jobs of the graph that run after other jobs
+        void DownstreamJobs(std::vector<Job*>& jobs) const;
+
+    private:
+        class Iteration;
+
+        // Adds a job to the graph and returns its index
+        std::uint32_t Add(Job& job);
+
+        // Moves the jobs of the other graph into this one
+        void Merge(JobGraph& other);
+
+        // Returns true if the job at the to index is reachable from the job at the from index
+        bool Reaches(std::uint32_t from, std::uint32_t to) const;
+
+        // Releases an iteration, handing the last root back to the runner if it was retired
+        void EndIteration(Runner* runner);
+
+    private:
+        std::vector<Job*> m_Jobs;
+        std::vector<std::vector<std::uint32_t>> m_Downstream; // The indices of the jobs that run after each job
+        std::vector<std::uint32_t> m_UpstreamCount;
+        std::vector<bool> m_RootRetired; // Guarded by the runner's lock
+        std::uint32_t m_RetiredRoots; // Guarded by the runner's lock
+        Job* m_LastRoot; // The root that the last iteration hands back to the runner
+        std::uint32_t m_MaxIterations;
+        std::atomic<std::uint32_t> m_State; // The iterations in flight, and whether all the roots were retired
+    };
+}
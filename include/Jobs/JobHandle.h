@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Jobs
+{
+    class Runner;
+
+    // A lightweight reference to a scheduled job: an index into the runner's job slot table
+    // and the generation of the slot at the time the job was registered.
+    // Once the job is canceled the slot's generation changes, so a stale handle never
+    // reaches another job that reuses the slot.
+    // A job that wasn't registered yet holds a handle to its runner with generation 0.
+    class JobHandle
+    {
+    public:
+        JobHandle()
+            : m_Runner(nullptr), m_Index(0), m_Generation(0)
+        {
+        }
+
+        JobHandle(Runner* runner, std::uint32_t index, std::uint32_t generation)
+            : m_Runner(runner), m_Index(index), m_Generation(generation)
+        {
+        }
+
+        // Returns true if the handle doesn't refer to a registered job
+        inline bool Empty() const
+        {
+            return m_Generation == 0;
+        }
+
+        inline Runner* GetRunner() const
+        {
+            return m_Runner;
+        }
+
+        inline std::uint32_t Index() const
+        {
+            return m_Index;
+        }
+
+        inline std::uint32_t Generation() const
+        {
+            return m_Generation;
+        }
+
+        inline bool operator==(const JobHandle& other) const
+        {
+            return m_Runner == other.m_Runner && m_Index == other.m_Index &&
+                   m_Generation == other.m_Generation;
+        }
+
+        inline bool operator!=(const JobHandle& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        Runner* m_Runner;
+        std::uint32_t m_Index;
+        std::uint32_t m_Generation;
+    };
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Jobs
+{
+    // Hands out storage for Job objects from contiguous slabs.
+    // Freed storage is recycled by later allocations, and slabs whose jobs were all freed
+    // are returned to the heap in bulk by Trim().
+    // NOTE(yuval): The pool isn't thread safe, the Runner only uses it under its mutex.
+    class JobPool
+    {
+    public:
+        // Ctor, Dtor
+        JobPool();
+        ~JobPool();
+
+        // No copy constructors for the JobPool
+        JobPool(const JobPool& other) = delete;
+        JobPool& operator=(const JobPool& other) = delete;
+
+        // Returns uninitialized storage for a single Job
+        void* Allocate();
+
+        // Returns storage that was handed out by Allocate to the pool
+        void Free(void* storage);
+
+        // Releases all the slabs that have no live jobs
+        void Trim();
+
+        // Returns the number of slabs the pool holds
+        inline std::size_t SlabCount() const
+        {
+            return m_Slabs.size();
+        }
+
+    private:
+        // The header at the start of every slab
+        struct Slab
+        {
+            std::size_t liveCount; // The number of jobs that were allocated and not freed
+        };
+
+        // A free item, linked through the storage it describes
+        struct FreeItem
+        {
+            FreeItem* next;
+        };
+
+        // Allocates a new slab and pushes its items to the free list
+        void AddSlab();
+
+        // Returns the slab an item belongs to (slabs are aligned to their size)
+        static Slab* SlabOf(void* item);
+
+    private:
+        std::vector<Slab*> m_Slabs;
+        FreeItem* m_FreeItems;
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Jobs
+{
+    // A point in time copy of a DurationHistogram
+    struct HistogramSnapshot
+    {
+        // Buckets: 0 - 3 hold 0 - 3 microseconds, and every following power of two range
+        // of microseconds is split into 4 buckets (values past the last bucket are counted in it)
+        static constexpr std::size_t SUB_BUCKETS = 4;
+        static constexpr std::size_t BUCKET_COUNT = 128;
+
+        std::uint64_t count;
+        std::chrono::microseconds sum;
+        std::chrono::microseconds max;
+        std::array<std::uint32_t, BUCKET_COUNT> buckets;
+
+        // Returns the mean of the recorded durations
+        std::chrono::microseconds Mean() const;
+
+        // Returns the duration that the given fraction (0 - 1) of the recorded durations
+        // is less than or equal to, up to the bucket's precision
+        std::chrono::microseconds Percentile(double fraction) const;
+
+        // Returns the smallest duration that is counted in the bucket
+        static std::chrono::microseconds BucketStart(std::size_t bucket);
+
+        // Returns the bucket that counts the duration
+        static std::size_t BucketOf(std::chrono::microseconds duration);
+    };
+
+    // A point in time copy of a job's statistics
+    struct JobStatsSnapshot
+    {
+        std::uint64_t runCount;
+        std::uint64_t exceptionCount; // Runs that threw an exception
+        HistogramSnapshot startLag; // From the scheduled run time to the start of the run
+        HistogramSnapshot queueWait; // From the dispatch to the executor to the start of the run
+        HistogramSnapshot runDuration;
+    };
+
+    // A log-linear histogram of durations with a microsecond resolution
+    // NOTE(yuval): Unless a job allows concurrent runs it never runs concurrently with itself, so there
+    //              is a single writer, and every update is a relaxed load and store instead of a locked
+    //              read-modify-write. Readers may take snapshots at any time.
+    class DurationHistogram
+    {
+    public:
+        DurationHistogram();
+
+        // Counts a duration (with a single writer unless concurrent is set)
+        void Record(std::chrono::microseconds duration, bool concurrent = false);
+
+        // Copies the histogram
+        HistogramSnapshot Snapshot() const;
+
+    private:
+        std::atomic<std::int64_t> m_Sum; // In microseconds
+        std::atomic<std::int64_t> m_Max; // In microseconds
+        std::array<std::atomic<std::uint32_t>, HistogramSnapshot::BUCKET_COUNT> m_Buckets;
+    };
+
+    // The execution statistics of a job
+    class JobStats
+    {
+    public:
+        // Ctor (concurrent is set for jobs whose runs may overlap)
+        explicit JobStats(bool concurrent = false);
+
+        // Records a dispatch of the run that was scheduled at the given time to the executor
+        // NOTE(yuval): The runs of a job that runs concurrently all see the latest dispatch.
+        inline void RecordDispatch(std::chrono::steady_clock::time_point scheduledTime,
+                                   std::chrono::steady_clock::time_point dispatchTime)
+        {
+            m_ScheduledTime.store(scheduledTime.time_since_epoch().count(), std::memory_order_relaxed);
+            m_DispatchTime.store(dispatchTime.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        // Records a run of the job that was last dispatched
+        void RecordRun(std::chrono::steady_clock::time_point startTime,
+                       std::chrono::steady_clock::time_point endTime, bool threw);
+
+        // Copies the statistics
+        JobStatsSnapshot Snapshot() const;
+
+    private:
+        bool m_Concurrent; // Runs may record concurrently
+        std::atomic<std::chrono::steady_clock::rep> m_ScheduledTime; // Handed from the timer thread to the worker with the job
+        std::atomic<std::chrono::steady_clock::rep> m_DispatchTime;
+        std::atomic<std::uint64_t> m_RunCount;
+        std::atomic<std::uint64_t> m_ExceptionCount;
+        DurationHistogram m_StartLag;
+        DurationHistogram m_QueueWait;
+        DurationHistogram m_RunDuration;
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Jobs/Job.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Jobs
+{
+    namespace JobStoreType
+    {
+        enum Type
+        {
+            MultiMap = 0, // Ordered std::multimap keyed by run time (O(log n) per operation)
+            TimingWheel // Hierarchical timing wheel (amortized O(1) per operation)
+        };
+    }
+
+    // The time index the Runner keeps its scheduled jobs in.
+    // Stores keep their per-job entries indexed by the job's slot (Job::Handle().Index()),
+    // so removing a job never has to search for it.
+    class JobStore
+    {
+    public:
+        // A job and the time it should run at
+        using Entry = std::pair<JOB_TIME_TYPE, Job*>;
+
+        virtual ~JobStore() = default;
+
+        // Creates a job store of the given type that starts at the given time
+        static std::unique_ptr<JobStore> Create(JobStoreType::Type type, JOB_TIME_TYPE now);
+
+        // Adds a job that should run at the given time (re-adding a stored job moves it)
+        virtual void Insert(JOB_TIME_TYPE time, Job* job) = 0;
+
+        // Adds jobs that aren't stored yet, the entries may be reordered
+        // (stores that can build their index faster from a whole batch override it)
+        virtual void InsertBatch(std::vector<Entry>& entries);
+
+        // Removes a job from the store, returns false if the job wasn't found
+        virtual bool Remove(Job* job) = 0;
+
+        // Removes all the jobs that should run at or before the given time
+        // and appends them to expired
+        virtual void PopExpired(JOB_TIME_TYPE now, std::vector<Job*>& expired) = 0;
+
+        // Removes all the jobs and appends them to jobs
+        virtual void PopAll(std::vector<Job*>& jobs) = 0;
+
+        // Returns the first job that matches the predicate, or nullptr
+        virtual Job* Find(const std::function<bool(Job*)>& pred) const = 0;
+
+        // Sets time to the run time of the earliest job,
+        // returns false if the store is empty
+        virtual bool NextRunTime(JOB_TIME_TYPE& time) const = 0;
+
+        // Returns the number of stored jobs
+        virtual std::size_t Size() const = 0;
+
+        // Allocates room for the given number of jobs up front,
+        // so storing up to that many jobs doesn't allocate
+        virtual void Reserve(std::size_t jobCount) = 0;
+
+        inline bool Empty() const
+        {
+            return Size() == 0;
+        }
+    };
+}
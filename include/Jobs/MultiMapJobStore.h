@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Jobs/JobStore.h"
+#include <map>
+
+#define JOB_MAP_TYPE std::multimap<JOB_TIME_TYPE, Job*>
+#define JOB_MAP_ITER JOB_MAP_TYPE::iterator
+
+namespace Jobs
+{
+    class MultiMapJobStore : public JobStore
+    {
+    public:
+        void Insert(JOB_TIME_TYPE time, Job* job) override;
+        void InsertBatch(std::vector<Entry>& entries) override;
+        bool Remove(Job* job) override;
+        void PopExpired(JOB_TIME_TYPE now, std::vector<Job*>& expired) override;
+        void PopAll(std::vector<Job*>& jobs) override;
+        Job* Find(const std::function<bool(Job*)>& pred) const override;
+        bool NextRunTime(JOB_TIME_TYPE& time) const override;
+        std::size_t Size() const override;
+        void Reserve(std::size_t jobCount) override;
+
+    private:
+        // Stores the job in a recycled map node, or in a new one if there are no free nodes
+        JOB_MAP_ITER Emplace(JOB_TIME_TYPE time, Job* job);
+
+        // Stores the job as close as possible before the hint, in amortized constant time
+        // if that is where it belongs
+        JOB_MAP_ITER Emplace(JOB_MAP_ITER hint, JOB_TIME_TYPE time, Job* job);
+
+    private:
+        JOB_MAP_TYPE m_Jobs;
+        std::vector<JOB_MAP_ITER> m_Entries; // Every job's map entry by slot (m_Jobs.end() if not stored)
+
+        // NOTE(yuval): Map nodes that were extracted from m_Jobs are recycled by later inserts,
+        //              so a job that fires and gets rescheduled doesn't free and allocate a node.
+        std::vector<JOB_MAP_TYPE::node_type> m_FreeNodes;
+    };
+}
@@ -1,48 +1,223 @@
 #pragma once
 
+#include "Jobs/Clock.h"
+#include "Jobs/Executor.h"
 #include "Jobs/InterruptableSleeper.h"
-#include "vendor/CTPL/ctpl_stl.h"
+#include "Jobs/JobHandle.h"
+#include "Jobs/JobPool.h"
+#include "Jobs/JobStore.h"
+#include "Jobs/RunnerMetrics.h"
+#include "Jobs/ScheduleSnapshot.h"
+#include "Jobs/StripedCounter.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
-#include <map>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <ostream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
-#define JOB_MAP_TYPE std::multimap<std::time_t, Job*>
-#define JOB_MAP_ITER JOB_MAP_TYPE::iterator
-
 namespace Jobs
 {
     class Job;
+    class Runner;
+
+    // A sleep of a coroutine job, co_await it to suspend the job without holding a worker
+    // (see Jobs/Coroutine.h)
+    struct JobSleep
+    {
+        Runner* runner;
+        Clock::Duration duration;
+    };
+
+    // Tells the objects that can outlive a runner (like a JobCompletion) whether it still exists.
+    // The runner ends its lifetime while it is destroyed, after which Acquire returns nullptr.
+    class RunnerLifetime
+    {
+    public:
+        explicit RunnerLifetime(Runner* runner)
+            : m_Runner(runner), m_State(0)
+        {
+        }
+
+        // Returns the runner and keeps it from being destroyed until Release is called,
+        // or returns nullptr if its lifetime ended
+        inline Runner* Acquire()
+        {
+            if (m_State.fetch_add(1, std::memory_order_acq_rel) & ENDED_BIT)
+            {
+                Release();
+                return nullptr;
+            }
+
+            return m_Runner;
+        }
+
+        inline void Release()
+        {
+            m_State.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        // Ends the runner's lifetime, waiting for the threads that acquired it to release it
+        inline void End()
+        {
+            m_State.fetch_or(ENDED_BIT, std::memory_order_acq_rel);
+
+            while ((m_State.load(std::memory_order_acquire) & ~ENDED_BIT) != 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        static constexpr std::uint32_t ENDED_BIT = 1u << 31;
+
+        Runner* m_Runner;
+        std::atomic<std::uint32_t> m_State; // The threads that acquired the runner, and whether its lifetime ended
+    };
 
     class Runner
     {
+        friend class Job;
+        friend class JobBatch;
+
     // Public Methods
     public:
-        Runner(unsigned int maxJobs = 12);
+        Runner(unsigned int maxJobs = 12, JobStoreType::Type storeType = JobStoreType::MultiMap,
+               ExecutorType::Type executorType = ExecutorType::ThreadPool);
+
+        // Creates a runner that dispatches its jobs to the given (possibly shared) executor,
+        // and reads the time from the given clock (the system clock if it is null)
+        // NOTE(yuval): A shared executor must be shut down before the runner is destroyed,
+        //              so no job that belongs to the runner is still running.
+        Runner(std::shared_ptr<Executor> executor,
+               JobStoreType::Type storeType = JobStoreType::MultiMap,
+               std::shared_ptr<Clock> clock = nullptr);
+
+        // Must not be called from the runner's own jobs, which are destroyed with it
         ~Runner();
 
-        // Job Run Loop
+        // Starts the job run loop on the runner's timer thread
         void Run();
 
         // Stops The Job Run Loop
         void Stop();
 
-        // Adding Jobs
-        void AddJob(std::time_t time, Job* job);
+        // Event Loop Embedding
+        // Returns a file descriptor that becomes readable when the runner has work to do, so an existing event
+        // loop (epoll, poll or select) can drive the runner instead of a timer thread: whenever the fd is
+        // readable, the loop calls ProcessReady. Throws a JobException if the runner was started with Run,
+        // or if it has no poll fd (Linux only).
+        int GetPollFd();
+
+        // Dispatches the jobs and timers that came due, stores the added jobs and re-arms the poll fd for the
+        // next job (called from the event loop's thread once the poll fd is readable)
+        void ProcessReady();
+
+        // Adding Jobs (a job that isn't registered yet gets a new handle)
+        // NOTE(yuval): Jobs are added through a lock-free inbox that the timer thread drains,
+        //              a job must not be added again before it was drained and ran.
+        JobHandle AddJob(JOB_TIME_TYPE time, Job* job);
+
+        // Adds jobs that weren't added to a runner yet (like the jobs of a JobBatch) at once: their first
+        // run times are computed in parallel for large batches, and they are stored with a single lock
+        // and a single wakeup of the timer thread. Returns their handles, in the order of the jobs.
+        std::vector<JobHandle> AddJobs(const std::vector<Job*>& jobs);
 
         // Job Running
         void RunPending();
         void RunAll();
 
+        // Advances the runner's VirtualClock by the given duration, moving it from one job run time
+        // to the next and running the jobs that are due at every step, so a simulated schedule fires
+        // every run it would have fired in real time. Throws a JobException if the clock isn't virtual.
+        // NOTE(yuval): With the Inline executor every run completes before the clock moves on. With other
+        //              executors jobs that are still running when the clock moves on fire late.
+        void AdvanceClock(Clock::Duration duration);
+
+        // Returns the clock that the runner and its jobs read the time from
+        inline Clock& GetClock() const
+        {
+            return *m_Clock;
+        }
+
+        // Returns the runner's lifetime, which the objects that can outlive the runner hold on to
+        inline const std::shared_ptr<RunnerLifetime>& GetLifetime() const
+        {
+            return m_Lifetime;
+        }
+
+        // Allocates room for the given number of jobs up front.
+        // NOTE(yuval): Once its jobs fired once, a runner that has reserved room for them
+        //              and runs them on a work-stealing executor doesn't allocate per run.
+        void Reserve(std::size_t jobCount);
+
+        // Runs the jobs of the given priority class on an executor lane of their own (on the runner's
+        // executor if it is null), so they don't wait behind the jobs of other classes.
+        // Must be called before jobs of the class are added. Lanes that aren't shared are shut down
+        // with the runner, like its executor.
+        void SetLane(JobPriority::Class priority, std::shared_ptr<Executor> executor);
+
+        // Spreads the jobs that come due together over the given window: every job that is added from now on
+        // is shifted by an offset within the window, hashed from its slot, for example a window of 10 seconds
+        // spreads jobs that run every minute over the first 10 seconds of the minute. Unlike To(), the offset
+        // is fixed, so the jobs keep their periods. The offset is hashed from the job's name or id, so it stays
+        // the same across restarts. Jobs without either are hashed by their handle, and runners that should
+        // spread those differently (like the shards of a ShardedRunner) pass different seeds.
+        // Must be called before jobs are added.
+        void Disperse(Clock::Duration window, std::uint32_t seed = 0);
+
+        // Returns the offset that dispersion shifts the job by (zero without dispersion)
+        Clock::Duration DispersionOffset(const Job& job) const;
+
+        // Dispatches at most maxJobs jobs every tick, the due jobs past that wait for the following ticks
+        // in the order they came due (a maxJobs of zero stops throttling)
+        void ThrottleDispatch(std::size_t maxJobs, Clock::Duration tick);
+
+        // Queues a task on the runner's executor (or on the lane of the given priority class)
+        void Submit(Task* task);
+        void Submit(Task* task, JobPriority::Class priority);
+
+        // Queues a task on the executor lane of the given priority class once the given time comes
+        // NOTE(yuval): Tasks that are still waiting when the runner is destroyed are run right away,
+        //              on the destroying thread.
+        void SubmitAt(JOB_TIME_TYPE time, Task* task, JobPriority::Class priority = JobPriority::Normal);
+
+        // Returns a sleep that suspends the coroutine job that awaits it for the given duration
+        inline JobSleep SleepFor(Clock::Duration duration)
+        {
+            return JobSleep{ this, duration };
+        }
+
         // Job Canceling
         void Clear();
         void CancelJob(Job* job);
 
-        // Finds a job and returns a pointer to it
-        // TODO(yuval): Define the function pointer type in Job.h!!!
-        Job* FindJob(const std::function<void(void)>& fn);
+        // Cancels the job the handle refers to, returns false if the handle is stale
+        bool CancelJob(const JobHandle& handle);
+
+        // Returns the job the handle refers to, or nullptr if the handle is stale
+        Job* GetJob(const JobHandle& handle);
+
+        // Finds a job that runs the given function pointer and returns a pointer to it (nullptr if there is none).
+        // Lambdas and other callables have no identity, so they are never found, look them up by name instead.
+        Job* FindJob(const JOB_FUNC_TYPE& fn);
+
+        // Returns the job with the given name (the one added last if several jobs share it), or nullptr
+        Job* FindJob(const std::string& name);
+
+        // Returns the handles of the jobs with the given tag
+        std::vector<JobHandle> FindByTag(const std::string& tag);
+
+        // Cancels the jobs with the given tag, and returns the number of jobs it canceled
+        std::size_t CancelByTag(const std::string& tag);
 
         // Schedules a new job
         Job& Every(int interval = 1);
@@ -54,21 +229,220 @@ namespace Jobs
         // Returns the number of seconds until the next run
         int IdleSeconds();
 
+        // Gets the run time of the next running job, returns false if there are no jobs
+        bool NextRunningJobTime(JOB_TIME_TYPE& time);
+
+        // Gets the next time the runner has a job or a task submitted with SubmitAt to run,
+        // returns false if it has neither
+        bool NextWakeupTime(JOB_TIME_TYPE& time);
+
+        // Writes the schedules of the jobs that have an id (see Job::Id) to a snapshot file,
+        // returns false if it failed
+        bool SaveSchedule(const std::string& path);
+
+        // Maps a snapshot file that SaveSchedule wrote, so the jobs that are added from now on with ids
+        // and schedules it holds resume their saved run times instead of starting from now, and the catch-up
+        // policy decides what happens to the runs they missed. Returns the number of jobs in the snapshot
+        // (0 if the file is missing or isn't a snapshot). Should be called before the jobs are added.
+        std::size_t RestoreSchedule(const std::string& path, CatchUpPolicy::Policy catchUp = CatchUpPolicy::Skip);
+
+        // Returns a snapshot of the runner's health metrics
+        RunnerMetrics Metrics();
+
+        // Writes the runner's metrics in the Prometheus text exposition format
+        void WriteMetrics(std::ostream& out);
+
+        // Writes the runner's metrics in the Prometheus text exposition format to the given file
+        // (or stream, that must outlive the export) every period, on a thread of its own.
+        // Calling it again replaces the previous export.
+        void ExportMetrics(const std::string& path, std::chrono::milliseconds period);
+        void ExportMetrics(std::ostream& out, std::chrono::milliseconds period);
+
+        // Stops exporting the runner's metrics
+        void StopExportingMetrics();
+
+    // Private Types
+    private:
+        enum JobSlotState
+        {
+            SlotFree = 0, // Not bound to a job
+            SlotScheduled, // The job is in the job store
+            SlotRunning // The job was dispatched or is waiting in the inbox
+        };
+
+        struct JobSlot
+        {
+            Job* job;
+            std::uint32_t generation; // Changes every time the slot's job is canceled
+            std::uint32_t nextFree; // The next free slot, while the slot is free
+            JobSlotState state;
+            bool canceled; // The running job should be destroyed instead of re-added
+        };
+
+        // A task that waits for its time to be submitted to the executor
+        struct Timer
+        {
+            JOB_TIME_TYPE time;
+            Task* task;
+            JobPriority::Class priority;
+        };
+
+        static constexpr std::uint32_t NO_SLOT = 0xFFFFFFFF;
+        static constexpr JOB_CLOCK_TYPE::rep AWAKE = std::numeric_limits<JOB_CLOCK_TYPE::rep>::min();
+
     // Private Methods
     private:
-        // Runs the given job
+        // Runs all the pending jobs (or all the jobs) once, and returns the number of jobs
+        // that were run or moved from the inbox to the job store
+        std::size_t RunExpired(bool all = false);
+
+        // Moves the popped jobs to the throttle backlog, and takes back as many jobs as the current
+        // tick may still dispatch, in the order they came due (m_Mutex must be locked)
+        void ThrottleJobsToRun(JOB_TIME_TYPE now);
+
+        // Reschedules a job with an overlap policy that was popped at the given time,
+        // and returns true if its run should be dispatched now (m_Mutex must be locked)
+        bool AdmitOverlapping(Job* job, JOB_TIME_TYPE now);
+
+        // Reserves an iteration of its graph for a root that was popped at the given time, or reschedules it
+        // if its graph has as many iterations in flight as it allows, returns true if its run should be
+        // dispatched now (m_Mutex must be locked)
+        bool AdmitIteration(Job* job, JOB_TIME_TYPE now);
+
+        // Gets the run time that the restored snapshot holds for a job that is being added,
+        // returns false if it holds none (called by Job::Do)
+        bool RestoreRun(Job* job, JOB_TIME_TYPE& time);
+        bool RestoreRunLocked(Job* job, JOB_TIME_TYPE& time);
+
+        // Allocates storage for the given number of jobs from the job pool, with a single lock (for JobBatch)
+        void AllocateJobs(std::size_t count, std::vector<void*>& storage);
+
+        // Returns job storage that holds no job to the job pool
+        void FreeJobs(const std::vector<void*>& storage);
+
+        // Hands the given job to the executor lane of its priority class
         void RunJob(Job* job);
 
+        // Calls the given function with every distinct executor the runner dispatches to
+        template <typename F>
+        void ForEachExecutor(F&& fn);
+
+        // Binds a job to a free slot and returns the job's new handle
+        JobHandle AcquireSlot(Job* job);
+
+        // Returns the slot the handle refers to, or nullptr if the handle is stale
+        JobSlot* FindSlot(const JobHandle& handle);
+
+        // Cancels the job in the given slot, jobs that are currently running
+        // are destroyed once they complete
+        void CancelSlot(std::uint32_t index);
+
+        // Adds a job that was bound to a slot to the name and tag indexes (m_Mutex must be locked)
+        void IndexJob(Job* job, const JobHandle& handle);
+
+        // Removes a job that is about to be destroyed from the name and tag indexes (m_Mutex must be locked)
+        void UnindexJob(Job* job);
+
+        // Deletes a job that is neither stored nor running and frees its slot
+        void DestroyJob(Job* job);
+
+        // Deletes a job that was removed from the job store, returns false if the job (that has an overlap
+        // policy, or is the last root of a graph) still has runs in flight, in which case it is destroyed
+        // once the last one completes
+        bool DestroyStoredJob(Job* job);
+
+        // Deletes a job object, returning its storage to the job pool if it came from there
+        void FreeJob(Job* job);
+
+        // Pushes a job to the inbox, and interrupts the sleeper if the job
+        // should run before the timer thread wakes up
+        void PushInbox(JOB_TIME_TYPE time, Job* job);
+
+        // Moves the jobs in the inbox to the job store, and returns the number of jobs it moved
+        // (m_Mutex must be locked)
+        std::size_t DrainInbox();
+
+        // The timer thread's run loop
+        void RunLoop();
+
+        // Dispatches the due jobs, drains the inbox and publishes the time that the runner wakes up at,
+        // returns false if it has no job or timer to wake up for (a single pass of the run loop)
+        bool Step(JOB_TIME_TYPE& wakeupTime, bool wokeUp);
+
+        // Gets the time of the next job or timer (m_Mutex must be locked)
+        bool NextWakeupTimeLocked(JOB_TIME_TYPE& time);
+
+        // Orders the timer heap so its front is the earliest timer
+        static bool TimerLater(const Timer& lhs, const Timer& rhs);
+
         // Finds the next running job and returns its run time
         std::tm* NextRunningJobTime();
 
     // Private Fields
     private:
-        bool m_IsRunning;
-        JOB_MAP_TYPE m_Jobs;
-        std::mutex m_Mutex;
+        std::atomic<bool> m_IsRunning;
+        std::atomic<bool> m_IsEmbedded; // An event loop drives the runner through its poll fd
+        std::thread m_TimerThread; // Runs the job run loop
+        std::shared_ptr<Clock> m_Clock;
+        std::shared_ptr<RunnerLifetime> m_Lifetime;
+        std::unique_ptr<JobStore> m_Jobs;
+        std::mutex m_RunMutex; // Serializes the job runs, so they can dispatch without holding m_Mutex
+        std::vector<Job*> m_JobsToRun; // Scratch buffer for the jobs popped from m_Jobs (guarded by m_RunMutex)
+        std::vector<Timer> m_TimersToRun; // Scratch buffer for the expired timers (guarded by m_RunMutex)
+        std::vector<Timer> m_Timers; // Tasks submitted with SubmitAt, a heap by time (guarded by m_Mutex)
+        JobPool m_JobPool; // The storage of the jobs that Every creates
+        std::vector<JobSlot> m_Slots; // The job slot table, indexed by JobHandle::Index()
+        std::uint32_t m_FreeSlots; // The first free slot (NO_SLOT if the table is full)
+        TimedMutex m_Mutex;
+        std::atomic<Job*> m_Inbox; // Added and rescheduled jobs that weren't stored yet
+        std::atomic<JOB_CLOCK_TYPE::rep> m_WakeupDeadline; // When the timer thread wakes up (AWAKE while it's awake)
         InterruptableSleeper m_Sleeper;
-        ctpl::thread_pool m_Threads;
+        std::shared_ptr<Executor> m_Executor;
+        std::array<std::shared_ptr<Executor>, JobPriority::COUNT> m_Lanes; // Lanes that were set with SetLane
+        std::array<Executor*, JobPriority::COUNT> m_LaneExecutors; // The executor of every class's lane
+        Clock::Duration m_DispersionWindow; // The window that jobs are spread over (zero without dispersion)
+        std::uint32_t m_DispersionSeed;
+
+        // Dispatch Throttling (guarded by m_Mutex)
+        std::size_t m_ThrottleJobs; // The jobs dispatched per tick (zero without throttling)
+        Clock::Duration m_ThrottleTick;
+        JOB_TIME_TYPE m_TickStart;
+        std::size_t m_TickBudget; // The jobs the current tick may still dispatch
+        std::vector<Job*> m_Backlog; // Due jobs that wait for a tick, from m_BacklogHead on
+        std::size_t m_BacklogHead;
+
+        // Name And Tag Indexes (guarded by m_Mutex)
+        // NOTE(yuval): The indexes hold handles, so entries of jobs that were canceled are stale and are
+        //              dropped lazily. Every tag counts its jobs that weren't destroyed yet, and its entries
+        //              are compacted once they outnumber them twice, so they stay O(matches).
+        struct TagIndex
+        {
+            std::vector<JobHandle> handles;
+            std::size_t jobCount; // The tag's jobs that weren't destroyed yet
+        };
+
+        std::unordered_map<std::string, JobHandle> m_Names;
+        std::unordered_map<std::string, TagIndex> m_Tags;
+
+        // Schedule Restoring (guarded by m_Mutex)
+        // NOTE(yuval): The snapshot stays mapped until every job it holds was added again.
+        ScheduleSnapshot m_Snapshot;
+        std::unordered_map<std::uint64_t, const ScheduleRecord*> m_SnapshotRecords; // Records by job id
+        SnapshotTimeBase m_SnapshotTimeBase;
+        CatchUpPolicy::Policy m_CatchUp;
+
+        // Metrics
+        // NOTE(yuval): The counters are striped per thread, so they don't add a contention point.
+        StripedCounter m_JobsFired;
+        StripedCounter m_SleeperWakeups;
+        StripedCounter m_SpuriousWakeups;
+        StripedCounter m_RunsSkipped;
+        StripedCounter m_RunsCoalesced;
+        StripedCounter m_RunsQueued;
+        std::mutex m_MetricsMutex; // Guards the previous snapshot's time and fired jobs (only taken by readers)
+        JOB_TIME_TYPE m_LastMetricsTime;
+        std::uint64_t m_LastJobsFired;
+        std::unique_ptr<MetricsExporter> m_MetricsExporter;
     };
 }
 
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Jobs/InterruptableSleeper.h"
+#include "Jobs/StripedCounter.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace Jobs
+{
+    // A point in time copy of a runner's health metrics
+    struct RunnerMetrics
+    {
+        std::chrono::steady_clock::time_point time; // When the metrics were taken
+        std::size_t storedJobs; // Jobs in the job store (jobs that are running or in the inbox aren't counted)
+        std::size_t throttledJobs; // Due jobs that wait for the dispatch throttle
+        std::size_t queuedTasks; // Tasks that were submitted to the executor but didn't start yet
+        unsigned int busyWorkers; // Executor workers that are running a task
+        unsigned int idleWorkers;
+        std::uint64_t jobsFired; // Jobs that were handed to the executor
+        double jobsFiredPerSecond; // Since the previous time the runner's metrics were taken
+        std::uint64_t runsSkipped; // Runs that were dropped by their job's overlap policy or by their graph's iteration limit
+        std::uint64_t runsCoalesced; // Runs that were merged into their job's pending run
+        std::uint64_t runsQueued; // Runs that waited for their job's previous run to complete
+        std::uint64_t sleeperWakeups; // Times the timer thread (or the poll fd) woke the runner up
+        std::uint64_t spuriousWakeups; // Wakeups that found no job to run and no job to store
+        std::uint64_t mutexAcquisitions;
+        std::uint64_t mutexContentions; // Acquisitions that had to wait for another thread
+        std::chrono::nanoseconds mutexWaitTime; // Total time spent waiting for the runner's mutex
+        std::chrono::nanoseconds mutexHoldTime; // Total time the runner's mutex was held
+
+        // Adds the runner side metrics of another runner (used to merge the shards of a ShardedRunner)
+        void AddRunner(const RunnerMetrics& other);
+    };
+
+    // Writes the metrics in the Prometheus text exposition format
+    void WritePrometheusText(std::ostream& out, const RunnerMetrics& metrics);
+
+    // Writes the metrics in the Prometheus text exposition format to a file.
+    // The file is replaced at once, so readers never see a partially written file.
+    // Returns false if the file couldn't be written.
+    bool WritePrometheusFile(const std::string& path, const RunnerMetrics& metrics);
+
+    // A mutex that measures how long it is waited for and held
+    // NOTE(yuval): An uncontended acquisition only reads the clock when it acquires and releases the mutex.
+    class TimedMutex
+    {
+        using Clock = std::chrono::steady_clock;
+
+    public:
+        // Ctor
+        TimedMutex() = default;
+
+        // No copy constructors for the TimedMutex
+        TimedMutex(const TimedMutex& other) = delete;
+        TimedMutex& operator=(const TimedMutex& other) = delete;
+
+        // Lockable
+        void lock();
+        bool try_lock();
+        void unlock();
+
+        // Copies the mutex's counters to the metrics
+        void Snapshot(RunnerMetrics& metrics) const;
+
+    private:
+        std::mutex m_Mutex;
+        Clock::time_point m_AcquireTime; // Only accessed by the thread that holds the mutex
+        StripedCounter m_Acquisitions;
+        StripedCounter m_Contentions;
+        StripedCounter m_WaitTime; // In nanoseconds
+        StripedCounter m_HoldTime; // In nanoseconds
+    };
+
+    // Calls an export function on a thread of its own every period
+    class MetricsExporter
+    {
+    public:
+        // Ctor, Dtor
+        MetricsExporter(std::function<void()> exportFunc, std::chrono::milliseconds period);
+        ~MetricsExporter();
+
+        // No copy constructors for the MetricsExporter
+        MetricsExporter(const MetricsExporter& other) = delete;
+        MetricsExporter& operator=(const MetricsExporter& other) = delete;
+
+    private:
+        // The exporter thread's run loop
+        void RunLoop();
+
+    private:
+        std::function<void()> m_ExportFunc;
+        std::chrono::milliseconds m_Period;
+        std::atomic<bool> m_IsRunning;
+        InterruptableSleeper m_Sleeper;
+        std::thread m_Thread;
+    };
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Jobs/Clock.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace Jobs
+{
+    namespace CatchUpPolicy
+    {
+        // What happens to the runs that a restored job missed while its process was down
+        enum Policy : std::uint8_t
+        {
+            Skip = 0, // The missed runs are skipped, the job resumes at its next run on its schedule (default)
+            RunOnce // The missed runs are collapsed into a single run that starts right away
+        };
+    }
+
+    // The schedule of a job with an id as a snapshot file stores it.
+    // Times are wall clock nanoseconds since the epoch, without the runner's dispersion offset.
+    struct ScheduleRecord
+    {
+        std::uint64_t id;
+        std::int64_t lastRun; // 0 if the job didn't run yet
+        std::int64_t nextRun;
+        std::int32_t interval;
+        std::uint8_t unit;
+        std::uint8_t hour; // The job's At() time (if RECORD_AT_TIME is set)
+        std::uint8_t minute;
+        std::uint8_t second;
+        std::int8_t startDay;
+        std::uint8_t flags;
+        std::uint8_t reserved[6];
+
+        static constexpr std::uint8_t RECORD_AT_TIME = 0x1;
+        static constexpr std::uint8_t RECORD_CRON = 0x2;
+    };
+
+    // Converts between a clock's times and the wall clock nanoseconds that snapshots store.
+    // NOTE(yuval): The base is taken with a single FromTimeT, so converting a job's time is plain arithmetic.
+    class SnapshotTimeBase
+    {
+    public:
+        SnapshotTimeBase()
+            : m_WallSeconds(0), m_Base()
+        {
+        }
+
+        explicit SnapshotTimeBase(const Clock& clock)
+            : m_WallSeconds(clock.WallTime()), m_Base(clock.FromTimeT(m_WallSeconds))
+        {
+        }
+
+        inline std::int64_t ToWall(Clock::TimePoint time) const
+        {
+            return static_cast<std::int64_t>(m_WallSeconds) * NANOSECONDS_PER_SECOND +
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_Base).count();
+        }
+
+        inline Clock::TimePoint FromWall(std::int64_t wallTime) const
+        {
+            return m_Base + std::chrono::duration_cast<Clock::Duration>(std::chrono::nanoseconds(
+                wallTime - static_cast<std::int64_t>(m_WallSeconds) * NANOSECONDS_PER_SECOND));
+        }
+
+    private:
+        static constexpr std::int64_t NANOSECONDS_PER_SECOND = 1000000000;
+
+        std::time_t m_WallSeconds;
+        Clock::TimePoint m_Base;
+    };
+
+    // A read-only view of a schedule snapshot file, mapped into memory.
+    // The file is a header followed by an array of ScheduleRecords, in the machine's byte order.
+    class ScheduleSnapshot
+    {
+    public:
+        // Ctor, Dtor
+        ScheduleSnapshot();
+        ~ScheduleSnapshot();
+
+        // No copy constructors for the ScheduleSnapshot
+        ScheduleSnapshot(const ScheduleSnapshot& other) = delete;
+        ScheduleSnapshot& operator=(const ScheduleSnapshot& other) = delete;
+
+        // Writes the records to a snapshot file, through a temporary file that is synced to the disk and renamed
+        // over the old one (syncing its directory after the rename), returns false if it failed
+        static bool Write(const std::string& path, const std::vector<ScheduleRecord>& records);
+
+        // Maps the snapshot file at the given path (unmapping the previous one),
+        // returns false if it is missing or isn't a snapshot
+        bool Open(const std::string& path);
+
+        // Unmaps the snapshot file
+        void Close();
+
+        inline const ScheduleRecord* Records() const
+        {
+            return m_Records;
+        }
+
+        inline std::size_t Size() const
+        {
+            return m_Count;
+        }
+
+    private:
+        void* m_Data; // The mapped file
+        std::size_t m_Length;
+        const ScheduleRecord* m_Records;
+        std::size_t m_Count;
+    };
+}
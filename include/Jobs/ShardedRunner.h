@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Jobs/Runner.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Jobs
+{
+    // Spreads jobs over independent Runner shards. Every shard has its own job store,
+    // lock, sleeper and timer thread, while all the shards share one executor,
+    // so adding, rescheduling and expiring jobs scales with the number of shards.
+    class ShardedRunner
+    {
+    // Public Methods
+    public:
+        ShardedRunner(unsigned int shardCount = std::thread::hardware_concurrency(),
+                      unsigned int maxJobs = 12,
+                      JobStoreType::Type storeType = JobStoreType::MultiMap,
+                      ExecutorType::Type executorType = ExecutorType::ThreadPool);
+
+        // Creates a sharded runner whose shards dispatch their jobs to the given executor,
+        // and read the time from the given clock (the system clock if it is null)
+        ShardedRunner(unsigned int shardCount, std::shared_ptr<Executor> executor,
+                      JobStoreType::Type storeType = JobStoreType::MultiMap,
+                      std::shared_ptr<Clock> clock = nullptr);
+        ~ShardedRunner();
+
+        // No copy constructors for the ShardedRunner
+        ShardedRunner(const ShardedRunner& other) = delete;
+        ShardedRunner& operator=(const ShardedRunner& other) = delete;
+
+        // Starts the job run loops of all the shards
+        void Run();
+
+        // Stops the job run loops of all the shards
+        void Stop();
+
+        // Returns an epoll fd over the poll fds of all the shards, so an event loop can drive the shards
+        // instead of their timer threads (see Runner::GetPollFd)
+        int GetPollFd();
+
+        // Processes the shards whose poll fds are readable, like Runner::ProcessReady
+        void ProcessReady();
+
+        // Job Running
+        void RunPending();
+        void RunAll();
+
+        // Advances the shards' VirtualClock by the given duration, like Runner::AdvanceClock
+        void AdvanceClock(Clock::Duration duration);
+
+        // Allocates room for the given number of jobs up front
+        void Reserve(std::size_t jobCount);
+
+        // Runs the jobs of the given priority class on an executor lane of their own, like Runner::SetLane
+        // (the shards share the lane)
+        void SetLane(JobPriority::Class priority, std::shared_ptr<Executor> executor);
+
+        // Spreads the jobs that come due together over the given window, like Runner::Disperse
+        // (every shard hashes its jobs with a seed of its own)
+        void Disperse(Clock::Duration window);
+
+        // Dispatches at most maxJobs jobs every tick, like Runner::ThrottleDispatch
+        // (every shard dispatches its share of them)
+        void ThrottleDispatch(std::size_t maxJobs, Clock::Duration tick);
+
+        // Job Canceling
+        void Clear();
+        void CancelJob(Job* job);
+        bool CancelJob(const JobHandle& handle);
+
+        // Returns the job the handle refers to, or nullptr if the handle is stale
+        Job* GetJob(const JobHandle& handle);
+
+        // Finds a job that runs the given function pointer and returns a pointer to it (nullptr if there is none).
+        // Lambdas and other callables have no identity, so they are never found, look them up by name instead.
+        Job* FindJob(const JOB_FUNC_TYPE& fn);
+
+        // Indexed lookups, like Runner's (every shard indexes its own jobs)
+        Job* FindJob(const std::string& name);
+        std::vector<JobHandle> FindByTag(const std::string& tag);
+        std::size_t CancelByTag(const std::string& tag);
+
+        // Schedules a new job on one of the shards
+        Job& Every(int interval = 1);
+
+        // Returns a string that represents the date and time when
+        // the next job should run
+        std::string NextRun();
+
+        // Returns the number of seconds until the next run
+        int IdleSeconds();
+
+        // Returns the merged health metrics of all the shards
+        RunnerMetrics Metrics();
+
+        // Writes the merged metrics in the Prometheus text exposition format
+        void WriteMetrics(std::ostream& out);
+
+        // Writes the merged metrics to the given file (or stream) every period, like Runner::ExportMetrics
+        void ExportMetrics(const std::string& path, std::chrono::milliseconds period);
+        void ExportMetrics(std::ostream& out, std::chrono::milliseconds period);
+
+        // Stops exporting the metrics
+        void StopExportingMetrics();
+
+        // Returns the number of shards
+        inline std::size_t ShardCount() const
+        {
+            return m_Shards.size();
+        }
+
+    // Private Methods
+    private:
+        // Returns the shard the handle belongs to, or nullptr
+        Runner* FindShard(const JobHandle& handle) const;
+
+        // Returns the shard whose next job runs first, or nullptr if there are no jobs
+        Runner* NextRunningShard();
+
+    // Private Fields
+    private:
+        std::shared_ptr<Executor> m_Executor;
+        std::array<std::shared_ptr<Executor>, JobPriority::COUNT> m_Lanes; // Shut down with the shared executor
+        std::vector<std::unique_ptr<Runner>> m_Shards;
+        std::atomic<std::uint64_t> m_JobCount; // Hashed to pick the shard of a new job
+        std::unique_ptr<MetricsExporter> m_MetricsExporter;
+        int m_PollFd; // Watches the shards' poll fds (-1 until GetPollFd is called)
+    };
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Jobs
+{
+    // The stripe that the current thread's counter updates go to
+    std::size_t CurrentStripe();
+
+    // A counter that is split into cache line sized stripes, so threads that bump it
+    // don't share a cache line. Every thread updates its own stripe, and readers merge the stripes.
+    class StripedCounter
+    {
+    public:
+        static constexpr std::size_t STRIPE_COUNT = 16;
+
+        // Ctor
+        StripedCounter();
+
+        // No copy constructors for the StripedCounter
+        StripedCounter(const StripedCounter& other) = delete;
+        StripedCounter& operator=(const StripedCounter& other) = delete;
+
+        // Adds the given amount to the current thread's stripe
+        inline void Add(std::uint64_t amount = 1)
+        {
+            m_Stripes[CurrentStripe()].value.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        // Returns the sum of all the stripes
+        std::uint64_t Load() const;
+
+    private:
+        struct alignas(64) Stripe
+        {
+            std::atomic<std::uint64_t> value;
+        };
+
+        std::array<Stripe, STRIPE_COUNT> m_Stripes;
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Jobs/Executor.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Jobs
+{
+    // A Chase-Lev work-stealing deque.
+    // The owning worker pushes and pops tasks at the bottom, while other workers
+    // steal tasks from the top without taking a lock.
+    class TaskDeque
+    {
+    public:
+        // Ctor, Dtor
+        TaskDeque(std::int64_t capacity = 1024);
+        ~TaskDeque();
+
+        // No copy constructors for the TaskDeque
+        TaskDeque(const TaskDeque& other) = delete;
+        TaskDeque& operator=(const TaskDeque& other) = delete;
+
+        // Pushes a task to the bottom of the deque (owner only)
+        void Push(Task* task);
+
+        // Pops the last pushed task, returns nullptr if the deque is empty (owner only)
+        Task* Pop();
+
+        // Steals the first pushed task, returns nullptr if the deque is empty
+        // or the task was taken by another thread
+        Task* Steal();
+
+        // Returns an estimate of the number of tasks in the deque
+        std::int64_t Size() const;
+
+    private:
+        // A circular array of tasks
+        struct Array
+        {
+            Array(std::int64_t capacity);
+
+            inline Task* Get(std::int64_t index) const
+            {
+                return tasks[index & (capacity - 1)].load(std::memory_order_relaxed);
+            }
+
+            inline void Put(std::int64_t index, Task* task)
+            {
+                tasks[index & (capacity - 1)].store(task, std::memory_order_relaxed);
+            }
+
+            std::int64_t capacity; // Always a power of two
+            std::unique_ptr<std::atomic<Task*>[]> tasks;
+        };
+
+        // Replaces the array with one of twice its capacity
+        Array* Grow(Array* array, std::int64_t top, std::int64_t bottom);
+
+    private:
+        std::atomic<std::int64_t> m_Top;
+        std::atomic<std::int64_t> m_Bottom;
+        std::atomic<Array*> m_Array;
+
+        // NOTE(yuval): Arrays that were replaced by Grow are kept alive until the deque
+        //              is destroyed, because a thief might still be reading from them.
+        std::vector<std::unique_ptr<Array>> m_Arrays;
+    };
+}
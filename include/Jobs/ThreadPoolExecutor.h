@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Jobs/Executor.h"
+#include "Jobs/StripedCounter.h"
+#include "vendor/CTPL/ctpl_stl.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Jobs
+{
+    // Runs tasks on a ctpl thread pool
+    // NOTE(yuval): ctpl boxes every submitted task in a std::function, so unlike the
+    //              work-stealing executor this executor allocates on every dispatch.
+    class ThreadPoolExecutor : public Executor
+    {
+    public:
+        // Ctor, Dtor
+        ThreadPoolExecutor(unsigned int workerCount);
+        ~ThreadPoolExecutor();
+
+        void Submit(Task* task) override;
+        void Shutdown() override;
+        unsigned int WorkerCount() const override;
+        std::size_t QueuedTaskCount() const override;
+        unsigned int BusyWorkerCount() const override;
+
+    private:
+        // The counters of a single ctpl thread (only written by the thread)
+        struct alignas(64) WorkerState
+        {
+            std::atomic<std::uint64_t> startedTasks;
+            std::atomic<bool> busy;
+        };
+
+    private:
+        unsigned int m_WorkerCount;
+        std::unique_ptr<WorkerState[]> m_WorkerStates; // Indexed by ctpl's thread id
+        StripedCounter m_SubmittedTasks;
+        ctpl::thread_pool m_Threads;
+    };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Jobs/JobStore.h"
+#include <cstdint>
+
+namespace Jobs
+{
+    // A hierarchical timing wheel with milliseconds, seconds, minutes, hours and days levels.
+    // Each level only holds the jobs that run inside the current slot of the level
+    // above it, so the levels are ordered and a slot is re-distributed (cascaded)
+    // into the lower levels once the wheel reaches it. Jobs that run beyond the
+    // days level are kept in an overflow list.
+    // NOTE(yuval): The wheel ticks once per millisecond, so a job runs (and NextRunTime
+    //              reports it) on the first tick at or after its run time.
+    class TimingWheelJobStore : public JobStore
+    {
+    public:
+        // Ctor, Dtor
+        TimingWheelJobStore(JOB_TIME_TYPE now);
+        ~TimingWheelJobStore();
+
+        void Insert(JOB_TIME_TYPE time, Job* job) override;
+        bool Remove(Job* job) override;
+        void PopExpired(JOB_TIME_TYPE now, std::vector<Job*>& expired) override;
+        void PopAll(std::vector<Job*>& jobs) override;
+        Job* Find(const std::function<bool(Job*)>& pred) const override;
+        bool NextRunTime(JOB_TIME_TYPE& time) const override;
+        std::size_t Size() const override;
+        void Reserve(std::size_t jobCount) override;
+
+    private:
+        // A job's entry, nodes are indexed by the job's slot and linked by index
+        struct Node
+        {
+            Job* job; // nullptr if the slot's job isn't stored
+            std::int64_t tick; // The first tick at or after the job's run time
+            std::uint32_t list; // The list the node is linked into
+            std::uint32_t prev;
+            std::uint32_t next;
+        };
+
+        static constexpr std::uint32_t NO_NODE = 0xFFFFFFFF;
+
+        static constexpr std::size_t LEVEL_COUNT = 5;
+        static constexpr std::size_t SLOT_COUNT = 1000 + 60 + 60 + 24 + 365;
+        static constexpr std::size_t READY_LIST = SLOT_COUNT; // Nodes whose tick has passed
+        static constexpr std::size_t OVERFLOW_LIST = SLOT_COUNT + 1; // Nodes beyond the days level
+        static constexpr std::size_t LIST_COUNT = SLOT_COUNT + 2;
+        static constexpr std::size_t OCCUPIED_WORD_COUNT = (SLOT_COUNT + 63) / 64;
+
+        // Links the node into the list that matches its tick
+        void Place(std::uint32_t node);
+
+        void Link(std::uint32_t node, std::size_t list);
+        void Unlink(std::uint32_t node);
+
+        // Re-places all the nodes of a list after the wheel moved
+        void Cascade(std::size_t list);
+
+        // Moves all the nodes of a list to expired
+        void Collect(std::size_t list, std::vector<Job*>& expired);
+
+        // Returns the earliest tick after the current one at which a node
+        // has to be collected or cascaded
+        std::int64_t NextEventTick() const;
+
+        // Returns the first occupied slot list in [first, last), or last if there is none
+        std::size_t NextOccupiedSlot(std::size_t first, std::size_t last) const;
+
+        // Returns the earliest tick in a list, without walking the list. If the list's earliest node left it,
+        // returns the tick at which the wheel reaches the list instead (the cascade refines it then).
+        std::int64_t MinTick(std::size_t list) const;
+
+        // Returns the list's level (LEVEL_COUNT for the ready and overflow lists)
+        static std::size_t LevelOf(std::size_t list);
+
+    private:
+        std::int64_t m_Current; // The last tick the wheel has processed
+        std::uint32_t m_Lists[LIST_COUNT]; // The first node of every list
+        std::int64_t m_MinTicks[LIST_COUNT]; // The earliest tick ever linked into every list since it was empty
+        bool m_StaleMins[LIST_COUNT]; // Whether the node with the list's earliest tick left it
+        std::uint64_t m_Occupied[OCCUPIED_WORD_COUNT]; // A bit per non-empty slot list
+        std::size_t m_LevelSizes[LEVEL_COUNT];
+        std::size_t m_Size;
+        std::vector<Node> m_Nodes;
+    };
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Jobs/Executor.h"
+#include "Jobs/TaskDeque.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Jobs
+{
+    // Runs tasks on workers that each own a Chase-Lev deque.
+    // Tasks submitted from a worker are pushed to its own deque, tasks submitted from
+    // other threads are spread over the workers' inboxes, and idle workers steal
+    // from randomly chosen victims.
+    // A task may release the executor's last owner, its worker's thread is then
+    // detached and exits as soon as the task returns.
+    class WorkStealingExecutor : public Executor
+    {
+    public:
+        // Ctor, Dtor
+        WorkStealingExecutor(unsigned int workerCount);
+        ~WorkStealingExecutor();
+
+        void Submit(Task* task) override;
+        void Shutdown() override;
+        unsigned int WorkerCount() const override;
+        void Reserve(std::size_t taskCount) override;
+        std::size_t QueuedTaskCount() const override;
+        unsigned int BusyWorkerCount() const override;
+
+    private:
+        struct Worker
+        {
+            TaskDeque deque;
+            std::mutex inboxMutex;
+            std::vector<Task*> inbox; // Tasks submitted from outside the executor
+            std::vector<Task*> drained; // The inbox tasks that are moved to the deque
+            std::uint64_t randomState; // Picks the stealing victims
+            std::atomic<bool> busy; // Only written by the worker
+            std::atomic<bool> joinClaimed; // Set by the shutdown that joins (or detaches) the thread
+            std::thread thread;
+        };
+
+        // The worker's run loop
+        void WorkerLoop(std::size_t index);
+
+        // Finds a task for the worker: from its deque, its inbox, or another worker
+        Task* FindTask(std::size_t index);
+
+        // Moves the worker's inbox to its deque and pops a task
+        Task* DrainInbox(Worker& worker);
+
+        // Steals a task from a random victim
+        Task* Steal(std::size_t index);
+
+        // Returns true if any worker has a queued task, checked by a worker before it sleeps
+        bool HasQueuedTasks();
+
+        // Wakes a sleeping worker after a task was queued
+        void WakeWorker();
+
+    private:
+        std::vector<std::unique_ptr<Worker>> m_Workers;
+        std::atomic<int> m_SleepingWorkers; // Workers that are about to sleep or sleep
+        std::atomic<std::uint64_t> m_WakeEpoch; // Bumped (with m_SleepMutex held) by every wakeup
+        std::atomic<bool> m_IsStopping;
+        std::mutex m_SleepMutex;
+        std::condition_variable m_SleepCV;
+    };
+}
@@ -0,0 +1,169 @@
+#include "Jobs/CivilTime.h"
+#include <algorithm>
+
+namespace Jobs
+{
+    namespace
+    {
+        constexpr std::int64_t SECONDS_PER_DAY = 24 * 60 * 60;
+
+        // The transition table covers the year before it was built and the following 20 years
+        constexpr std::time_t TABLE_PAST = 366 * SECONDS_PER_DAY;
+        constexpr std::time_t TABLE_FUTURE = 20 * 366 * SECONDS_PER_DAY;
+
+        inline std::int64_t FloorDiv(std::int64_t a, std::int64_t b)
+        {
+            return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+        }
+    }
+
+    // NOTE(yuval): The civil date conversions are the days_from_civil and civil_from_days
+    //              algorithms from Howard Hinnant's "chrono-Compatible Low-Level Date Algorithms".
+    std::int64_t DaysFromCivil(std::int64_t year, int month, int day)
+    {
+        year -= month <= 2;
+
+        std::int64_t era = FloorDiv(year, 400);
+        std::int64_t yearOfEra = year - era * 400; // [0, 399]
+        std::int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+        std::int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear; // [0, 146096]
+
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    void CivilFromDays(std::int64_t days, std::int64_t& year, int& month, int& day)
+    {
+        days += 719468;
+
+        std::int64_t era = FloorDiv(days, 146097);
+        std::int64_t dayOfEra = days - era * 146097; // [0, 146096]
+        std::int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365; // [0, 399]
+        std::int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100); // [0, 365]
+        std::int64_t monthPrime = (5 * dayOfYear + 2) / 153; // [0, 11]
+
+        day = static_cast<int>(dayOfYear - (153 * monthPrime + 2) / 5 + 1);
+        month = static_cast<int>(monthPrime < 10 ? monthPrime + 3 : monthPrime - 9);
+        year = yearOfEra + era * 400 + (month <= 2);
+    }
+
+    const TimeZone& TimeZone::Local()
+    {
+        // NOTE(yuval): The table is built once, by the first thread that needs it
+        static const TimeZone local(std::time(nullptr) - TABLE_PAST, std::time(nullptr) + TABLE_FUTURE);
+        return local;
+    }
+
+    int TimeZone::OffsetAt(std::time_t utc) const
+    {
+        if (utc < m_Transitions.front().utc || utc >= m_End)
+        {
+            return ProbeOffset(utc);
+        }
+
+        // Finding the last transition at or before the given time
+        std::vector<Transition>::const_iterator next = std::upper_bound(
+            m_Transitions.begin(), m_Transitions.end(), utc,
+            [](std::time_t time, const Transition& transition) { return time < transition.utc; });
+
+        return (next - 1)->offset;
+    }
+
+    CivilTime TimeZone::ToCivil(std::time_t utc) const
+    {
+        std::int64_t local = static_cast<std::int64_t>(utc) + OffsetAt(utc);
+        std::int64_t days = FloorDiv(local, SECONDS_PER_DAY);
+        std::int64_t secondOfDay = local - days * SECONDS_PER_DAY;
+
+        CivilTime civil;
+        CivilFromDays(days, civil.year, civil.month, civil.day);
+        civil.hour = static_cast<int>(secondOfDay / 3600);
+        civil.minute = static_cast<int>(secondOfDay / 60 % 60);
+        civil.second = static_cast<int>(secondOfDay % 60);
+
+        // 1970-01-01 was a Thursday
+        civil.weekDay = static_cast<int>(days + 4 - FloorDiv(days + 4, 7) * 7);
+
+        return civil;
+    }
+
+    std::time_t TimeZone::FromCivil(const CivilTime& local) const
+    {
+        // Normalizing the month, days and times of day can overflow freely into the day count
+        std::int64_t monthIndex = local.month - 1;
+        std::int64_t year = local.year + FloorDiv(monthIndex, 12);
+        int month = static_cast<int>(monthIndex - FloorDiv(monthIndex, 12) * 12) + 1;
+
+        std::int64_t localSeconds = DaysFromCivil(year, month, 1) * SECONDS_PER_DAY +
+                                    (static_cast<std::int64_t>(local.day) - 1) * SECONDS_PER_DAY +
+                                    static_cast<std::int64_t>(local.hour) * 3600 +
+                                    static_cast<std::int64_t>(local.minute) * 60 + local.second;
+
+        // NOTE(yuval): Offsets change at most once within a couple of days, so the local time is either
+        //              in the offset of the day before it, or in the offset of the day after it.
+        int offsetBefore = OffsetAt(static_cast<std::time_t>(localSeconds - SECONDS_PER_DAY));
+        int offsetAfter = OffsetAt(static_cast<std::time_t>(localSeconds + SECONDS_PER_DAY));
+        std::time_t before = static_cast<std::time_t>(localSeconds - offsetBefore);
+
+        if (offsetBefore == offsetAfter || OffsetAt(before) == offsetBefore)
+        {
+            return before;
+        }
+
+        std::time_t after = static_cast<std::time_t>(localSeconds - offsetAfter);
+
+        // A skipped local time keeps the offset from before the change, like std::mktime
+        return OffsetAt(after) == offsetAfter ? after : before;
+    }
+
+    TimeZone::TimeZone(std::time_t begin, std::time_t end)
+        : m_End(end)
+    {
+        m_Transitions.push_back(Transition{ begin, ProbeOffset(begin) });
+
+        // Probing the offset once a day, and binary searching the exact second of every change
+        for (std::time_t day = begin + SECONDS_PER_DAY; day < end; day += SECONDS_PER_DAY)
+        {
+            int offset = ProbeOffset(day);
+
+            if (offset == m_Transitions.back().offset)
+            {
+                continue;
+            }
+
+            std::time_t before = day - SECONDS_PER_DAY;
+            std::time_t after = day;
+
+            while (after - before > 1)
+            {
+                std::time_t middle = before + (after - before) / 2;
+
+                if (ProbeOffset(middle) == offset)
+                {
+                    after = middle;
+                }
+                else
+                {
+                    before = middle;
+                }
+            }
+
+            m_Transitions.push_back(Transition{ after, offset });
+        }
+    }
+
+    int TimeZone::ProbeOffset(std::time_t utc)
+    {
+        std::tm local;
+
+#ifdef _WIN32
+        localtime_s(&local, &utc);
+#else
+        localtime_r(&utc, &local);
+#endif
+
+        std::int64_t localSeconds = DaysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * SECONDS_PER_DAY +
+                                    local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+
+        return static_cast<int>(localSeconds - utc);
+    }
+}
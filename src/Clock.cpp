@@ -0,0 +1,123 @@
+#include "Jobs/Clock.h"
+#include "Jobs/InterruptableSleeper.h"
+#include <algorithm>
+
+namespace Jobs
+{
+    const std::shared_ptr<Clock>& Clock::System()
+    {
+        static const std::shared_ptr<Clock> systemClock = std::make_shared<SystemClock>();
+        return systemClock;
+    }
+
+    Clock::TimePoint SystemClock::Now() const
+    {
+        return std::chrono::steady_clock::now();
+    }
+
+    std::time_t SystemClock::WallTime() const
+    {
+        return std::time(nullptr);
+    }
+
+    Clock::TimePoint SystemClock::FromTimeT(std::time_t time) const
+    {
+        std::chrono::system_clock::duration fromNow = std::chrono::system_clock::from_time_t(time) -
+                                                      std::chrono::system_clock::now();
+
+        return std::chrono::steady_clock::now() + std::chrono::duration_cast<Duration>(fromNow);
+    }
+
+    std::time_t SystemClock::ToTimeT(TimePoint time) const
+    {
+        Duration fromNow = time - std::chrono::steady_clock::now();
+
+        return std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now() +
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(fromNow));
+    }
+
+    bool SystemClock::IsRealTime() const
+    {
+        return true;
+    }
+
+    VirtualClock::VirtualClock(std::time_t start)
+        : m_Start(std::chrono::floor<std::chrono::seconds>(std::chrono::steady_clock::now())),
+          m_WallStart(start), m_Now(m_Start.time_since_epoch().count())
+    {
+        // NOTE(yuval): The clock starts at the real monotonic time rather than at the epoch,
+        //              since jobs take a zero time point to mean that they never ran. It starts at
+        //              a whole second, so the run times of the jobs fall on timing wheel ticks.
+    }
+
+    Clock::TimePoint VirtualClock::Now() const
+    {
+        return TimePoint(Duration(m_Now.load(std::memory_order_acquire)));
+    }
+
+    std::time_t VirtualClock::WallTime() const
+    {
+        return ToTimeT(Now());
+    }
+
+    Clock::TimePoint VirtualClock::FromTimeT(std::time_t time) const
+    {
+        return m_Start + std::chrono::seconds(time - m_WallStart);
+    }
+
+    std::time_t VirtualClock::ToTimeT(TimePoint time) const
+    {
+        // Rounding down, so a time is in the wall clock second that it belongs to
+        Duration fromStart = time - m_Start;
+        std::chrono::seconds seconds = std::chrono::duration_cast<std::chrono::seconds>(fromStart);
+
+        if (seconds > fromStart)
+        {
+            seconds -= std::chrono::seconds(1);
+        }
+
+        return m_WallStart + static_cast<std::time_t>(seconds.count());
+    }
+
+    bool VirtualClock::IsRealTime() const
+    {
+        return false;
+    }
+
+    void VirtualClock::AddSleeper(InterruptableSleeper* sleeper)
+    {
+        std::lock_guard<std::mutex> lock(m_SleepersMutex);
+        m_Sleepers.push_back(sleeper);
+    }
+
+    void VirtualClock::RemoveSleeper(InterruptableSleeper* sleeper)
+    {
+        std::lock_guard<std::mutex> lock(m_SleepersMutex);
+        m_Sleepers.erase(std::remove(m_Sleepers.begin(), m_Sleepers.end(), sleeper), m_Sleepers.end());
+    }
+
+    void VirtualClock::AdvanceTo(TimePoint time)
+    {
+        Duration::rep now = m_Now.load(std::memory_order_relaxed);
+
+        // NOTE(yuval): Concurrent advances keep the latest time
+        while (now < time.time_since_epoch().count() &&
+               !m_Now.compare_exchange_weak(now, time.time_since_epoch().count(), std::memory_order_acq_rel))
+        {
+        }
+
+        // Waking the sleepers, so they check whether the time they sleep until has come
+        std::lock_guard<std::mutex> lock(m_SleepersMutex);
+
+        for (InterruptableSleeper* sleeper : m_Sleepers)
+        {
+            sleeper->Interrupt();
+        }
+    }
+
+    void VirtualClock::AdvanceBy(Duration duration)
+    {
+        AdvanceTo(Now() + duration);
+    }
+}
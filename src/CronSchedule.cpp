@@ -0,0 +1,326 @@
+#include "Jobs/CronSchedule.h"
+#include "Jobs/Bits.h"
+#include "Jobs/CivilTime.h"
+#include "Jobs/Job.h"
+#include <cctype>
+#include <sstream>
+#include <vector>
+
+namespace Jobs
+{
+    namespace
+    {
+        const char* const MONTH_NAMES[] = { "JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+                                            "JUL", "AUG", "SEP", "OCT", "NOV", "DEC", nullptr };
+        const char* const DAY_NAMES[] = { "SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT", nullptr };
+
+        // Schedules that match at all match within 8 years (February 29th skips 2100)
+        constexpr std::int64_t MAX_SEARCH_YEARS = 9;
+
+        // Returns the lowest set bit at or above the given bit, or -1 if there is none
+        inline int NextSetBit(std::uint64_t mask, int bit)
+        {
+            if (bit > 63)
+            {
+                return -1;
+            }
+
+            std::uint64_t word = mask & (~std::uint64_t(0) << bit);
+            return word == 0 ? -1 : static_cast<int>(LowestSetBit(word));
+        }
+
+        inline bool IsLeapYear(std::int64_t year)
+        {
+            return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        }
+
+        inline int DaysInMonth(std::int64_t year, int month)
+        {
+            static const int DAYS_IN_MONTH[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+            return month == 2 && IsLeapYear(year) ? 29 : DAYS_IN_MONTH[month - 1];
+        }
+
+        // Moves a civil time to the start of its next day, hour or minute
+        inline void NextDay(CivilTime& time)
+        {
+            ++time.day;
+            time.hour = 0;
+            time.minute = 0;
+            time.second = 0;
+        }
+
+        inline void NextMonth(CivilTime& time)
+        {
+            if (++time.month > 12)
+            {
+                time.month = 1;
+                ++time.year;
+            }
+
+            time.day = 1;
+            time.hour = 0;
+            time.minute = 0;
+            time.second = 0;
+        }
+    }
+
+    CronSchedule::CronSchedule(const std::string& expression)
+    {
+        std::vector<std::string> fields;
+        std::istringstream stream(expression);
+        std::string field;
+
+        while (stream >> field)
+        {
+            fields.push_back(field);
+        }
+
+        if (fields.size() != 5 && fields.size() != 6)
+        {
+            throw JobException("Invalid Cron Expression");
+        }
+
+        // The second field is optional
+        std::size_t first = 0;
+
+        if (fields.size() == 6)
+        {
+            m_Seconds = ParseField(fields[first++], 0, 59, nullptr);
+        }
+        else
+        {
+            m_Seconds = 1;
+        }
+
+        m_Minutes = ParseField(fields[first], 0, 59, nullptr);
+        m_Hours = static_cast<std::uint32_t>(ParseField(fields[first + 1], 0, 23, nullptr));
+        m_DaysOfMonth = static_cast<std::uint32_t>(ParseField(fields[first + 2], 1, 31, nullptr));
+        m_Months = static_cast<std::uint16_t>(ParseField(fields[first + 3], 1, 12, MONTH_NAMES));
+
+        // Sunday can be given as either 0 or 7
+        std::uint64_t daysOfWeek = ParseField(fields[first + 4], 0, 7, DAY_NAMES);
+        m_DaysOfWeek = static_cast<std::uint8_t>((daysOfWeek | (daysOfWeek >> 7)) & 0x7F);
+
+        m_DaysOfMonthRestricted = fields[first + 2][0] != '*';
+        m_DaysOfWeekRestricted = fields[first + 4][0] != '*';
+    }
+
+    bool CronSchedule::Next(std::time_t after, std::time_t& next) const
+    {
+        const TimeZone& zone = TimeZone::Local();
+        CivilTime time = zone.ToCivil(after + 1);
+        std::int64_t lastYear = time.year + MAX_SEARCH_YEARS;
+
+        // NOTE(yuval): Every field is advanced to its next set bit in one scan, and a field that
+        //              runs out of bits carries into the field above it, so the search takes
+        //              a few steps per field instead of one step per minute.
+        while (time.year <= lastYear)
+        {
+            int month = NextSetBit(m_Months, time.month);
+
+            if (month == -1)
+            {
+                time.month = 12;
+                NextMonth(time);
+                continue;
+            }
+
+            if (month != time.month)
+            {
+                time.month = month;
+                time.day = 1;
+                time.hour = 0;
+                time.minute = 0;
+                time.second = 0;
+            }
+
+            int day = NextSetBit(DayMask(time.year, time.month), time.day);
+
+            if (day == -1)
+            {
+                NextMonth(time);
+                continue;
+            }
+
+            if (day != time.day)
+            {
+                time.day = day;
+                time.hour = 0;
+                time.minute = 0;
+                time.second = 0;
+            }
+
+            int hour = NextSetBit(m_Hours, time.hour);
+
+            if (hour == -1)
+            {
+                NextDay(time);
+                continue;
+            }
+
+            if (hour != time.hour)
+            {
+                time.hour = hour;
+                time.minute = 0;
+                time.second = 0;
+            }
+
+            int minute = NextSetBit(m_Minutes, time.minute);
+
+            if (minute == -1)
+            {
+                ++time.hour;
+                time.minute = 0;
+                time.second = 0;
+                continue;
+            }
+
+            if (minute != time.minute)
+            {
+                time.minute = minute;
+                time.second = 0;
+            }
+
+            int second = NextSetBit(m_Seconds, time.second);
+
+            if (second == -1)
+            {
+                ++time.minute;
+                time.second = 0;
+                continue;
+            }
+
+            time.second = second;
+            next = zone.FromCivil(time);
+
+            // A local time that repeats when the clocks are turned back might map to an earlier instant
+            if (next > after)
+            {
+                return true;
+            }
+
+            ++time.second;
+        }
+
+        return false;
+    }
+
+    std::uint64_t CronSchedule::ParseField(const std::string& field, int min, int max, const char* const* names)
+    {
+        std::uint64_t mask = 0;
+        std::istringstream stream(field);
+        std::string item;
+
+        while (std::getline(stream, item, ','))
+        {
+            int first = min;
+            int last = max;
+            int step = 1;
+
+            std::string::size_type slash = item.find('/');
+            std::string range = item.substr(0, slash);
+
+            if (slash != std::string::npos)
+            {
+                step = ParseValue(item.substr(slash + 1), 0, nullptr);
+            }
+
+            if (range != "*")
+            {
+                std::string::size_type dash = range.find('-');
+                first = ParseValue(range.substr(0, dash), min, names);
+
+                if (dash != std::string::npos)
+                {
+                    last = ParseValue(range.substr(dash + 1), min, names);
+                }
+                else if (slash == std::string::npos)
+                {
+                    last = first;
+                }
+            }
+
+            if (step <= 0 || first < min || last > max || first > last)
+            {
+                throw JobException("Invalid Cron Expression");
+            }
+
+            for (int value = first; value <= last; value += step)
+            {
+                mask |= std::uint64_t(1) << value;
+            }
+        }
+
+        if (mask == 0)
+        {
+            throw JobException("Invalid Cron Expression");
+        }
+
+        return mask;
+    }
+
+    int CronSchedule::ParseValue(const std::string& value, int min, const char* const* names)
+    {
+        if (value.empty())
+        {
+            throw JobException("Invalid Cron Expression");
+        }
+
+        // Matching the value against the field's names (e.g. "MON")
+        if (names != nullptr && std::isalpha(static_cast<unsigned char>(value[0])))
+        {
+            for (int i = 0; names[i] != nullptr; ++i)
+            {
+                if (value.size() == 3 &&
+                    std::toupper(static_cast<unsigned char>(value[0])) == names[i][0] &&
+                    std::toupper(static_cast<unsigned char>(value[1])) == names[i][1] &&
+                    std::toupper(static_cast<unsigned char>(value[2])) == names[i][2])
+                {
+                    return min + i;
+                }
+            }
+
+            throw JobException("Invalid Cron Expression");
+        }
+
+        int number = 0;
+
+        for (char digit : value)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(digit)) || number > 1000)
+            {
+                throw JobException("Invalid Cron Expression");
+            }
+
+            number = number * 10 + (digit - '0');
+        }
+
+        return number;
+    }
+
+    std::uint32_t CronSchedule::DayMask(std::int64_t year, int month) const
+    {
+        int daysInMonth = DaysInMonth(year, month);
+        std::uint32_t monthDays = static_cast<std::uint32_t>(((std::uint64_t(1) << daysInMonth) - 1) << 1);
+
+        // Spreading the week days over the days of the month, starting from the week day of the 1st
+        std::int64_t firstDay = DaysFromCivil(year, month, 1);
+        int firstWeekDay = static_cast<int>(((firstDay + 4) % 7 + 7) % 7);
+        std::uint32_t weekDays = 0;
+
+        for (int offset = 0; offset < 7; ++offset)
+        {
+            if (m_DaysOfWeek & (1 << ((firstWeekDay + offset) % 7)))
+            {
+                // Days 1 + offset, 8 + offset, 15 + offset, 22 + offset and 29 + offset
+                weekDays |= 0x10204081u << (offset + 1);
+            }
+        }
+
+        // NOTE(yuval): Like cron, a day field that starts with "*" (even "*/2") makes both fields required
+        std::uint32_t days = m_DaysOfMonthRestricted && m_DaysOfWeekRestricted ? m_DaysOfMonth | weekDays :
+                                                                                 m_DaysOfMonth & weekDays;
+
+        return days & monthDays;
+    }
+}
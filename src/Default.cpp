@@ -39,11 +39,31 @@ namespace Jobs
         defaultRunner.CancelJob(job);
     }
 
+    bool CancelJob(const JobHandle& handle)
+    {
+        return defaultRunner.CancelJob(handle);
+    }
+
     Job* FindJob(const JOB_FUNC_TYPE& fn)
     {
         return defaultRunner.FindJob(fn);
     }
 
+    Job* FindJob(const std::string& name)
+    {
+        return defaultRunner.FindJob(name);
+    }
+
+    std::vector<JobHandle> FindByTag(const std::string& tag)
+    {
+        return defaultRunner.FindByTag(tag);
+    }
+
+    std::size_t CancelByTag(const std::string& tag)
+    {
+        return defaultRunner.CancelByTag(tag);
+    }
+
     std::string NextRun()
     {
         return defaultRunner.NextRun();
@@ -0,0 +1,23 @@
+#include "Jobs/Executor.h"
+#include "Jobs/InlineExecutor.h"
+#include "Jobs/ThreadPoolExecutor.h"
+#include "Jobs/WorkStealingExecutor.h"
+
+namespace Jobs
+{
+    std::shared_ptr<Executor> Executor::Create(ExecutorType::Type type, unsigned int workerCount)
+    {
+        switch (type)
+        {
+        case ExecutorType::WorkStealing:
+            return std::make_shared<WorkStealingExecutor>(workerCount);
+
+        case ExecutorType::Inline:
+            return std::make_shared<InlineExecutor>();
+
+        case ExecutorType::ThreadPool:
+        default:
+            return std::make_shared<ThreadPoolExecutor>(workerCount);
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#include "Jobs/InlineExecutor.h"
+
+namespace Jobs
+{
+    void InlineExecutor::Submit(Task* task)
+    {
+        task->Execute();
+    }
+
+    void InlineExecutor::Shutdown()
+    {
+    }
+
+    unsigned int InlineExecutor::WorkerCount() const
+    {
+        // The thread that submits the tasks is the only worker
+        return 1;
+    }
+}
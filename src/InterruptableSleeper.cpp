@@ -1,5 +1,15 @@
 #include "Jobs/InterruptableSleeper.h"
 
+#if JOBS_POLL_FD
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
 #define MUTEX_UNIQUE_LOCK(name) std::unique_lock<std::mutex> name(m_Mutex)
 #define SLEEP_IMPL(sleepFunc) MUTEX_UNIQUE_LOCK(lock); \
     sleepFunc; \
@@ -7,45 +17,198 @@
 
 namespace Jobs
 {
-    InterruptableSleeper::InterruptableSleeper()
-        : m_Interrupted(false)
+    InterruptableSleeper::InterruptableSleeper(Clock* clock)
+        : m_Clock(clock), m_Interrupted(false), m_PollFd(-1), m_TimerFd(-1), m_EventFd(-1)
     {
+#if JOBS_POLL_FD
+        // NOTE(yuval): steady_clock reads CLOCK_MONOTONIC, so the clock's times arm the timer as they are
+        m_TimerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        m_EventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_PollFd = ::epoll_create1(EPOLL_CLOEXEC);
+
+        epoll_event timerEvent = {};
+        timerEvent.events = EPOLLIN;
+        epoll_event interruptEvent = {};
+        interruptEvent.events = EPOLLIN;
+
+        if (m_TimerFd == -1 || m_EventFd == -1 || m_PollFd == -1 ||
+            ::epoll_ctl(m_PollFd, EPOLL_CTL_ADD, m_TimerFd, &timerEvent) != 0 ||
+            ::epoll_ctl(m_PollFd, EPOLL_CTL_ADD, m_EventFd, &interruptEvent) != 0)
+        {
+            ClosePollFd();
+        }
+#endif
+
+        m_Clock->AddSleeper(this);
     }
 
     InterruptableSleeper::~InterruptableSleeper()
     {
+        m_Clock->RemoveSleeper(this);
+        ClosePollFd();
     }
 
-    void InterruptableSleeper::SleepFor(Clock::duration duration)
+    void InterruptableSleeper::SleepFor(Clock::Duration duration)
     {
+        if (!m_Clock->IsRealTime())
+        {
+            SleepUntil(m_Clock->Now() + duration);
+            return;
+        }
+
+        if (m_PollFd != -1)
+        {
+            Arm(m_Clock->Now() + duration);
+            Wait();
+            Consume();
+            return;
+        }
+
         // Sleeping for the given duration or until the sleeper gets interrupted
         SLEEP_IMPL(m_CV.wait_for(lock, duration, [this] { return m_Interrupted; }));
     }
 
-    void InterruptableSleeper::SleepUntil(std::time_t time)
+    void InterruptableSleeper::SleepUntil(Clock::TimePoint time)
     {
-        SleepUntil(Clock::from_time_t(time));
-    }
+        if (m_PollFd != -1)
+        {
+            // The clock interrupts its sleepers whenever it advances, if it isn't real time
+            if (m_Clock->IsRealTime() || m_Clock->Now() < time)
+            {
+                Arm(time);
+                Wait();
+            }
+
+            Consume();
+            return;
+        }
+
+        if (!m_Clock->IsRealTime())
+        {
+            // The clock interrupts its sleepers whenever it advances
+            SLEEP_IMPL(m_CV.wait(lock, [this, time] { return m_Interrupted || m_Clock->Now() >= time; }));
+            return;
+        }
 
-    void InterruptableSleeper::SleepUntil(Clock::time_point time)
-    {
         // Sleeping until the given time point or until the sleeper gets interrupted
         SLEEP_IMPL(m_CV.wait_until(lock, time, [this] { return m_Interrupted; }));
     }
 
     void InterruptableSleeper::Sleep()
     {
+        if (m_PollFd != -1)
+        {
+            Disarm();
+            Wait();
+            Consume();
+            return;
+        }
+
         // Sleeping until the sleeper gets interrupted
         SLEEP_IMPL(m_CV.wait(lock, [this] { return m_Interrupted; }));
     }
 
     void InterruptableSleeper::Interrupt()
     {
+#if JOBS_POLL_FD
+        if (m_PollFd != -1)
+        {
+            // NOTE(yuval): The eventfd stays readable until it is consumed, so an interrupt
+            //              that comes before the sleeper waits isn't lost.
+            std::uint64_t one = 1;
+            ssize_t written = ::write(m_EventFd, &one, sizeof(one));
+            (void)written;
+            return;
+        }
+#endif
+
         std::lock_guard<std::mutex> lock(m_Mutex);
 
         // Interrupting the sleeper
         m_Interrupted = true;
         m_CV.notify_one();
     }
-}
 
+    void InterruptableSleeper::Arm(Clock::TimePoint time)
+    {
+#if JOBS_POLL_FD
+        if (m_PollFd == -1)
+        {
+            return;
+        }
+
+        if (!m_Clock->IsRealTime())
+        {
+            Disarm();
+            return;
+        }
+
+        // NOTE(yuval): A zero time disarms the timer, so a time at or before the epoch expires right away instead
+        std::int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+
+        itimerspec spec = {};
+        spec.it_value.tv_sec = static_cast<time_t>(nanoseconds <= 0 ? 0 : nanoseconds / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(nanoseconds <= 0 ? 1 : nanoseconds % 1000000000);
+        ::timerfd_settime(m_TimerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+#else
+        (void)time;
+#endif
+    }
+
+    void InterruptableSleeper::Disarm()
+    {
+#if JOBS_POLL_FD
+        if (m_PollFd != -1)
+        {
+            itimerspec spec = {};
+            ::timerfd_settime(m_TimerFd, 0, &spec, nullptr);
+        }
+#endif
+    }
+
+    bool InterruptableSleeper::Consume()
+    {
+#if JOBS_POLL_FD
+        if (m_PollFd == -1)
+        {
+            return false;
+        }
+
+        // Both file descriptors are non-blocking, a read only succeeds if it had something to clear
+        std::uint64_t count;
+        bool interrupted = ::read(m_EventFd, &count, sizeof(count)) == sizeof(count);
+        bool expired = ::read(m_TimerFd, &count, sizeof(count)) == sizeof(count);
+
+        return interrupted || expired;
+#else
+        return false;
+#endif
+    }
+
+    void InterruptableSleeper::Wait()
+    {
+#if JOBS_POLL_FD
+        pollfd pollFd = {};
+        pollFd.fd = m_PollFd;
+        pollFd.events = POLLIN;
+
+        while (::poll(&pollFd, 1, -1) == -1 && errno == EINTR)
+        {
+        }
+#endif
+    }
+
+    void InterruptableSleeper::ClosePollFd()
+    {
+#if JOBS_POLL_FD
+        for (int* fd : { &m_PollFd, &m_TimerFd, &m_EventFd })
+        {
+            if (*fd != -1)
+            {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+#endif
+    }
+}
@@ -1,7 +1,13 @@
 #include "Jobs/Job.h"
+#include "Jobs/CivilTime.h"
+#include "Jobs/CronSchedule.h"
+#include "Jobs/JobGraph.h"
 #include "Jobs/Runner.h"
 #include <algorithm>
+#include <atomic>
 #include <iterator>
+#include <memory>
+#include <random>
 #include <sstream>
 
 #define CHECK_INTERVAL_AND_THROW(type) if (m_Interval != 1) \
@@ -11,6 +17,96 @@
 
 namespace Jobs
 {
+    static_assert(sizeof(Job) <= 64 + sizeof(JOB_FUNC_TYPE), "A job should take at most 64 bytes besides its job function");
+
+    namespace
+    {
+        // A splitmix64 generator, small enough to be shared by all the jobs that run on a thread
+        class RandomGenerator
+        {
+        public:
+            using result_type = std::uint64_t;
+
+            RandomGenerator()
+            {
+                // Seeding every thread's generator once
+                std::random_device rd;
+                m_State = (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+            }
+
+            static constexpr result_type min()
+            {
+                return 0;
+            }
+
+            static constexpr result_type max()
+            {
+                return ~static_cast<result_type>(0);
+            }
+
+            inline result_type operator()()
+            {
+                std::uint64_t z = (m_State += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+        private:
+            std::uint64_t m_State;
+        };
+
+        thread_local RandomGenerator t_Random;
+
+        // Who completes the current run of a coroutine job
+        enum AsyncState : std::uint8_t
+        {
+            AsyncIdle = 0, // Not running
+            AsyncRunning, // Execute runs the job function
+            AsyncSuspended, // Execute returned, the coroutine completes the run
+            AsyncDone // The coroutine completed, Execute completes the run
+        };
+
+        // The overlap state word of a job: its running runs, its pending runs and whether it was canceled
+        constexpr std::uint32_t OVERLAP_LIMIT = 0x7FFF;
+        constexpr std::uint32_t RUNNING_MASK = OVERLAP_LIMIT;
+        constexpr std::uint32_t PENDING_SHIFT = 15;
+        constexpr std::uint32_t PENDING_ONE = 1u << PENDING_SHIFT;
+        constexpr std::uint32_t PENDING_MASK = OVERLAP_LIMIT << PENDING_SHIFT;
+        constexpr std::uint32_t CANCELED_BIT = 1u << 31;
+    }
+
+    struct Job::Extension
+    {
+        std::unique_ptr<CronSchedule> cron; // The cron schedule the job runs on
+        std::time_t lastCronRun = 0; // The wall clock time of the last scheduled cron run
+        bool collectStats = false; // The statistics are allocated once the job is added
+        std::unique_ptr<JobStats> stats; // The execution statistics (if the job collects them)
+
+        // Schedule snapshots
+        std::uint64_t id = 0; // The job's stable id (0 if it has none)
+        JOB_TIME_TYPE lastRun; // The time the job was last dispatched
+
+        // Indexed lookup
+        std::string name;
+        std::vector<std::string> tags;
+
+        // Job graphs
+        std::shared_ptr<JobGraph> graph; // The graph the job belongs to (shared by its jobs)
+        std::uint32_t graphIndex = 0;
+
+        // Coroutine jobs
+        bool isAsync = false; // The job function starts a coroutine that might outlive Execute
+        bool asyncThrew = false; // The current run's coroutine threw an exception
+        std::atomic<std::uint8_t> asyncState{ AsyncIdle }; // Who completes the current run
+        JOB_TIME_TYPE asyncStart; // The start time of the current run
+
+        // Overlapping runs
+        OverlapPolicy::Policy overlap = OverlapPolicy::None;
+        std::uint32_t overlapLimit = 1; // The maximum pending (Queue) or running (Concurrent) runs
+        std::atomic<std::uint32_t> overlapState{ 0 }; // See RUNNING_MASK, PENDING_MASK and CANCELED_BIT
+    };
+
     JobException::JobException(const std::string& msg)
         : m_Msg(msg)
     {
@@ -22,18 +118,38 @@ namespace Jobs
     }
 
     Job::Job(int interval, Runner* runner)
-        : m_Interval(interval), m_Latest(-1), m_StartDay(-1),
-          m_AtTime(nullptr), m_LastRun(nullptr),
-          m_Runner(runner), m_Gen(m_Rd())
+        : m_Interval(interval), m_Latest(-1), m_AtTime{ 0, 0, 0, false }, m_StartDay(-1),
+          m_Unit(JobUnit::Seconds), m_Pooled(false), m_Priority(JobPriority::Normal), m_Handle(runner, 0, 0), m_InboxNext(nullptr), m_Ext(nullptr)
     {
     }
 
     Job::~Job()
     {
-        if (m_AtTime != nullptr)
-        {
-            delete m_AtTime;
-        }
+        delete m_Ext;
+    }
+
+    Job& Job::Microsecond()
+    {
+        CHECK_INTERVAL_AND_THROW("Microsecond");
+        return Microseconds();
+    }
+
+    Job& Job::Microseconds()
+    {
+        m_Unit = JobUnit::Microseconds;
+        return *this;
+    }
+
+    Job& Job::Millisecond()
+    {
+        CHECK_INTERVAL_AND_THROW("Millisecond");
+        return Milliseconds();
+    }
+
+    Job& Job::Milliseconds()
+    {
+        m_Unit = JobUnit::Milliseconds;
+        return *this;
     }
 
     Job& Job::Second()
@@ -192,49 +308,541 @@ namespace Jobs
             shouldThrow = true;
         }
 
-        if (shouldThrow)
+        if (shouldThrow || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59)
         {
             throw JobException("Invalid Time");
         }
 
-        if (m_AtTime != nullptr)
+        m_AtTime.hour = static_cast<std::uint8_t>(hour);
+        m_AtTime.minute = static_cast<std::uint8_t>(minute);
+        m_AtTime.second = static_cast<std::uint8_t>(second);
+        m_AtTime.isSet = true;
+
+        return *this;
+    }
+
+    Job& Job::To(int latest)
+    {
+        m_Latest = latest;
+        return *this;
+    }
+
+    Job& Job::Cron(const std::string& expression)
+    {
+        std::unique_ptr<CronSchedule> cron(new CronSchedule(expression));
+        std::time_t next;
+
+        if (!cron->Next(JobClock().WallTime(), next))
         {
-            delete m_AtTime;
+            throw JobException("Cron Expression Never Matches");
         }
 
-        m_AtTime = new tm;
-        m_AtTime->tm_hour = hour;
-        m_AtTime->tm_min = minute;
-        m_AtTime->tm_sec = second;
+        Ext().cron = std::move(cron);
+        Ext().lastCronRun = 0;
+        return *this;
+    }
+
+    Job& Job::CollectStats()
+    {
+        Ext().collectStats = true;
+        return *this;
+    }
 
+    Job& Job::Priority(JobPriority::Class priority)
+    {
+        m_Priority = priority;
         return *this;
     }
 
-    Job& Job::To(int latest)
+    Job& Job::Id(std::uint64_t id)
     {
-        m_Latest = latest;
+        if (id == 0)
+        {
+            throw JobException("A Job Id Can't Be 0");
+        }
+
+        Ext().id = id;
         return *this;
     }
 
-    Job& Job::Do(const JOB_FUNC_TYPE& jobFunc)
+    std::uint64_t Job::GetId() const
     {
-        m_JobFunc = jobFunc;
+        return m_Ext == nullptr ? 0 : m_Ext->id;
+    }
 
-        if (m_Runner != nullptr)
+    Job& Job::Name(const std::string& name)
+    {
+        Ext().name = name;
+        return *this;
+    }
+
+    Job& Job::Tag(const std::string& tag)
+    {
+        std::vector<std::string>& tags = Ext().tags;
+
+        if (std::find(tags.begin(), tags.end(), tag) == tags.end())
         {
-            m_Runner->AddJob(GetNextRun(), this);
+            tags.push_back(tag);
         }
 
         return *this;
     }
 
+    const std::string& Job::GetName() const
+    {
+        static const std::string noName;
+        return m_Ext == nullptr ? noName : m_Ext->name;
+    }
+
+    const std::vector<std::string>& Job::GetTags() const
+    {
+        static const std::vector<std::string> noTags;
+        return m_Ext == nullptr ? noTags : m_Ext->tags;
+    }
+
+    Job& Job::After(Job& upstream)
+    {
+        JobGraph::Connect(upstream, *this);
+        return *this;
+    }
+
+    Job& Job::Then(Job& downstream)
+    {
+        JobGraph::Connect(*this, downstream);
+        return downstream;
+    }
+
+    Job& Job::MaxIterations(unsigned int limit)
+    {
+        JobGraph::Of(*this).MaxIterations(limit);
+        return *this;
+    }
+
+    JobStatsSnapshot Job::Stats() const
+    {
+        if (m_Ext == nullptr || m_Ext->stats == nullptr)
+        {
+            return JobStats().Snapshot();
+        }
+
+        return m_Ext->stats->Snapshot();
+    }
+
+    Job& Job::Overlap(OverlapPolicy::Policy policy, unsigned int limit)
+    {
+        if (limit == 0 || limit > OVERLAP_LIMIT)
+        {
+            throw JobException("Invalid Overlap Limit");
+        }
+
+        // NOTE(yuval): Jobs without a policy don't allocate the extension
+        if (policy != OverlapPolicy::None || m_Ext != nullptr)
+        {
+            Ext().overlap = policy;
+            Ext().overlapLimit = limit;
+        }
+
+        return *this;
+    }
+
+    JobHandle Job::Do(JOB_FUNC_TYPE&& jobFunc)
+    {
+        // NOTE(yuval): A job that doesn't move forward would come due again at the time it ran,
+        //              and the run loop (or a VirtualClock advance) would never get past it
+        if (m_Interval <= 0 && (m_Ext == nullptr || m_Ext->cron == nullptr))
+        {
+            throw JobException("Interval Must Be Positive");
+        }
+
+        // NOTE(yuval): A coroutine job keeps the state of its current run in the job
+        if (m_Ext != nullptr && m_Ext->isAsync && m_Ext->overlap == OverlapPolicy::Concurrent && m_Ext->overlapLimit > 1)
+        {
+            throw JobException("A Coroutine Job Can't Run Concurrently");
+        }
+
+        // NOTE(yuval): The graph's iterations run its jobs and hand its roots back to the runner themselves
+        if (m_Ext != nullptr && m_Ext->graph != nullptr)
+        {
+            if (m_Ext->overlap != OverlapPolicy::None)
+            {
+                throw JobException("A Job Of A Graph Can't Have An Overlap Policy");
+            }
+
+            if (m_Ext->isAsync && m_Ext->graph->HasUpstream(m_Ext->graphIndex))
+            {
+                throw JobException("A Coroutine Job Can't Run After Other Jobs");
+            }
+        }
+
+        m_JobFunc = std::move(jobFunc);
+
+        if (m_Handle.GetRunner() == nullptr)
+        {
+            return JobHandle();
+        }
+
+        AllocateStats();
+
+        // A job that runs after other jobs only runs in its graph's iterations
+        if (m_Ext != nullptr && m_Ext->graph != nullptr && m_Ext->graph->HasUpstream(m_Ext->graphIndex))
+        {
+            return JobHandle();
+        }
+
+        // A job that a restored snapshot holds resumes its saved schedule instead of computing a new one
+        Runner* runner = m_Handle.GetRunner();
+        JOB_TIME_TYPE nextRun;
+
+        if (m_Ext == nullptr || m_Ext->id == 0 || !runner->RestoreRun(this, nextRun))
+        {
+            nextRun = GetNextRun();
+        }
+
+        return runner->AddJob(nextRun, this);
+    }
+
     void Job::Run()
     {
         m_JobFunc();
-        m_LastRun = GetLocalTime();
     }
 
-    std::time_t Job::GetNextRun()
+    void Job::Execute()
+    {
+        JobStats* stats = m_Ext == nullptr ? nullptr : m_Ext->stats.get();
+        JOB_TIME_TYPE startTime = stats == nullptr ? JOB_TIME_TYPE() : JobClock().Now();
+        bool isAsync = m_Ext != nullptr && m_Ext->isAsync;
+        bool threw = false;
+
+        if (isAsync)
+        {
+            m_Ext->asyncStart = startTime;
+            m_Ext->asyncThrew = false;
+            m_Ext->asyncState = AsyncRunning;
+        }
+
+        // An exception thrown by the job function must not take the worker down with it
+        try
+        {
+            Run();
+        }
+        catch (...)
+        {
+            threw = true;
+        }
+
+        if (isAsync)
+        {
+            // A coroutine that suspended completes the run itself, once it completes
+            // NOTE(yuval): A job function that threw never started its coroutine.
+            if (!threw && m_Ext->asyncState.exchange(AsyncSuspended) == AsyncRunning)
+            {
+                return;
+            }
+
+            threw = threw || m_Ext->asyncThrew;
+            m_Ext->asyncState = AsyncIdle;
+        }
+
+        Complete(startTime, threw);
+    }
+
+    void Job::Complete(JOB_TIME_TYPE startTime, bool threw)
+    {
+        JobStats* stats = m_Ext == nullptr ? nullptr : m_Ext->stats.get();
+        bool hasOverlapPolicy = m_Ext != nullptr && m_Ext->overlap != OverlapPolicy::None;
+
+        // A job with an overlap policy was already rescheduled when it was dispatched
+        if (hasOverlapPolicy)
+        {
+            if (stats != nullptr)
+            {
+                stats->RecordRun(startTime, JobClock().Now(), threw);
+            }
+
+            CompleteOverlapping();
+            return;
+        }
+
+        // NOTE(yuval): The end of the run is read once, for the statistics and the next run time
+        JOB_TIME_TYPE endTime = JobClock().Now();
+
+        if (stats != nullptr)
+        {
+            stats->RecordRun(startTime, endTime, threw);
+        }
+
+        // The run of a graph's root starts an iteration of the jobs downstream of it
+        if (m_Ext != nullptr && m_Ext->graph != nullptr)
+        {
+            m_Ext->graph->StartIteration(this, threw);
+        }
+
+        // NOTE(yuval): Re-adding the job doesn't take any lock, the job is pushed
+        //              to the runner's inbox straight from the worker that ran it.
+        m_Handle.GetRunner()->AddJob(GetNextRun(endTime), this);
+    }
+
+    bool Job::HasOverlapPolicy() const
+    {
+        return m_Ext != nullptr && m_Ext->overlap != OverlapPolicy::None;
+    }
+
+    Job::RunAdmission Job::Admit()
+    {
+        std::atomic<std::uint32_t>& state = m_Ext->overlapState;
+        std::uint32_t current = state.load(std::memory_order_relaxed);
+        std::uint32_t next;
+        RunAdmission admission;
+
+        do
+        {
+            std::uint32_t running = current & RUNNING_MASK;
+            std::uint32_t pending = (current & PENDING_MASK) >> PENDING_SHIFT;
+            std::uint32_t maxRunning = m_Ext->overlap == OverlapPolicy::Concurrent ? m_Ext->overlapLimit : 1;
+            std::uint32_t maxPending = m_Ext->overlap == OverlapPolicy::Queue ? m_Ext->overlapLimit :
+                                       m_Ext->overlap == OverlapPolicy::Coalesce ? 1 : 0;
+
+            if (running < maxRunning)
+            {
+                next = current + 1;
+                admission = AdmitRun;
+            }
+            else if (pending < maxPending)
+            {
+                // NOTE(yuval): Under Coalesce the run still becomes the pending run,
+                //              but it is counted with the runs that are merged into it
+                next = current + PENDING_ONE;
+                admission = m_Ext->overlap == OverlapPolicy::Coalesce ? AdmitCoalesced : AdmitQueued;
+            }
+            else
+            {
+                return m_Ext->overlap == OverlapPolicy::Coalesce ? AdmitCoalesced : AdmitSkipped;
+            }
+        } while (!state.compare_exchange_weak(current, next, std::memory_order_acq_rel));
+
+        return admission;
+    }
+
+    bool Job::RetireOverlapping()
+    {
+        // The pending runs are dropped, the running ones complete
+        std::uint32_t current = m_Ext->overlapState.load(std::memory_order_relaxed);
+
+        while (!m_Ext->overlapState.compare_exchange_weak(current, (current & RUNNING_MASK) | CANCELED_BIT,
+                                                          std::memory_order_acq_rel))
+        {
+        }
+
+        return (current & RUNNING_MASK) == 0;
+    }
+
+    void Job::CompleteOverlapping()
+    {
+        std::atomic<std::uint32_t>& state = m_Ext->overlapState;
+        std::uint32_t current = state.load(std::memory_order_relaxed);
+        std::uint32_t next;
+
+        // A pending run takes over the running run's place, otherwise the run leaves
+        do
+        {
+            next = (current & PENDING_MASK) != 0 ? current - PENDING_ONE : current - 1;
+        } while (!state.compare_exchange_weak(current, next, std::memory_order_acq_rel));
+
+        // NOTE(yuval): The pending run is submitted again instead of running right here,
+        //              so a slow job doesn't hold on to its worker.
+        if ((current & PENDING_MASK) != 0)
+        {
+            m_Handle.GetRunner()->Submit(this, m_Priority);
+        }
+        else if (next == CANCELED_BIT)
+        {
+            // The last run of a canceled job hands it back to the runner, which destroys it
+            m_Handle.GetRunner()->AddJob(JOB_TIME_TYPE(), this);
+        }
+    }
+
+    void Job::MarkAsync()
+    {
+        Ext().isAsync = true;
+    }
+
+    void Job::AsyncThrew()
+    {
+        m_Ext->asyncThrew = true;
+    }
+
+    void Job::AsyncCompleted()
+    {
+        // The run completes here only if Execute already returned
+        if (m_Ext->asyncState.exchange(AsyncDone) == AsyncSuspended)
+        {
+            m_Ext->asyncState = AsyncIdle;
+            Complete(m_Ext->asyncStart, m_Ext->asyncThrew);
+        }
+    }
+
+    void Job::AllocateStats()
+    {
+        if (m_Ext != nullptr && m_Ext->collectStats && m_Ext->stats == nullptr)
+        {
+            // NOTE(yuval): The jobs of a graph run once per iteration, and its iterations might overlap
+            bool concurrent = (m_Ext->overlap == OverlapPolicy::Concurrent && m_Ext->overlapLimit > 1) ||
+                              (m_Ext->graph != nullptr && m_Ext->graph->GetMaxIterations() > 1);
+            m_Ext->stats.reset(new JobStats(concurrent));
+        }
+    }
+
+    void Job::Dispatched(JOB_TIME_TYPE now)
+    {
+        if (m_Ext != nullptr)
+        {
+            if (m_Ext->stats != nullptr)
+            {
+                m_Ext->stats->RecordDispatch(m_NextRun, now);
+            }
+
+            m_Ext->lastRun = now;
+        }
+    }
+
+    void Job::ToRecord(ScheduleRecord& record, const SnapshotTimeBase& base) const
+    {
+        // NOTE(yuval): The run time is stored without the dispersion offset, since the job might be
+        //              bound to another slot (and so shifted by another offset) once it is restored.
+        record.id = m_Ext->id;
+        record.lastRun = m_Ext->lastRun == JOB_TIME_TYPE() ? 0 : base.ToWall(m_Ext->lastRun);
+        record.nextRun = base.ToWall(m_NextRun - DispersionOffset());
+        record.interval = m_Interval;
+        record.unit = m_Unit;
+        record.hour = m_AtTime.hour;
+        record.minute = m_AtTime.minute;
+        record.second = m_AtTime.second;
+        record.startDay = m_StartDay;
+        record.flags = (m_AtTime.isSet ? ScheduleRecord::RECORD_AT_TIME : 0) |
+                       (m_Ext->cron != nullptr ? ScheduleRecord::RECORD_CRON : 0);
+        std::fill(std::begin(record.reserved), std::end(record.reserved), static_cast<std::uint8_t>(0));
+    }
+
+    bool Job::MatchesRecord(const ScheduleRecord& record) const
+    {
+        bool isCron = m_Ext != nullptr && m_Ext->cron != nullptr;
+
+        if (record.interval != m_Interval || record.unit != m_Unit || record.startDay != m_StartDay ||
+            ((record.flags & ScheduleRecord::RECORD_CRON) != 0) != isCron ||
+            ((record.flags & ScheduleRecord::RECORD_AT_TIME) != 0) != m_AtTime.isSet)
+        {
+            return false;
+        }
+
+        return !m_AtTime.isSet || (record.hour == m_AtTime.hour && record.minute == m_AtTime.minute &&
+                                   record.second == m_AtTime.second);
+    }
+
+    JOB_TIME_TYPE Job::Restore(const ScheduleRecord& record, const SnapshotTimeBase& base,
+                               CatchUpPolicy::Policy catchUp, JOB_TIME_TYPE now)
+    {
+        JOB_TIME_TYPE nextRun = base.FromWall(record.nextRun);
+
+        if (record.lastRun != 0)
+        {
+            m_Ext->lastRun = base.FromWall(record.lastRun);
+        }
+
+        // The cron search continues after the saved run
+        if (m_Ext->cron != nullptr)
+        {
+            m_Ext->lastCronRun = static_cast<std::time_t>(record.nextRun / 1000000000);
+        }
+
+        m_NextRun = nextRun;
+
+        if (nextRun >= now)
+        {
+            return nextRun;
+        }
+
+        // The job missed runs while its process was down
+        if (catchUp == CatchUpPolicy::RunOnce)
+        {
+            return now;
+        }
+
+        // NOTE(yuval): The search starts from the missed run, so an interval job keeps its phase
+        return GetNextRun(now);
+    }
+
+    JobGraph* Job::Graph() const
+    {
+        return m_Ext == nullptr ? nullptr : m_Ext->graph.get();
+    }
+
+    std::shared_ptr<JobGraph> Job::SharedGraph() const
+    {
+        return m_Ext == nullptr ? nullptr : m_Ext->graph;
+    }
+
+    std::uint32_t Job::GraphIndex() const
+    {
+        return m_Ext == nullptr ? 0 : m_Ext->graphIndex;
+    }
+
+    void Job::JoinGraph(std::shared_ptr<JobGraph> graph, std::uint32_t index)
+    {
+        Ext().graph = std::move(graph);
+        m_Ext->graphIndex = index;
+    }
+
+    bool Job::RunDownstream()
+    {
+        JobStats* stats = m_Ext->stats.get();
+        JOB_TIME_TYPE startTime = stats == nullptr ? JOB_TIME_TYPE() : JobClock().Now();
+        bool threw = false;
+
+        try
+        {
+            Run();
+        }
+        catch (...)
+        {
+            threw = true;
+        }
+
+        if (stats != nullptr)
+        {
+            stats->RecordRun(startTime, JobClock().Now(), threw);
+        }
+
+        return !threw;
+    }
+
+    Clock& Job::JobClock() const
+    {
+        Runner* runner = m_Handle.GetRunner();
+        return runner == nullptr ? *Clock::System() : runner->GetClock();
+    }
+
+    JOB_CLOCK_TYPE::duration Job::DispersionOffset() const
+    {
+        Runner* runner = m_Handle.GetRunner();
+        return runner == nullptr ? JOB_CLOCK_TYPE::duration::zero() : runner->DispersionOffset(*this);
+    }
+
+    Job::Extension& Job::Ext()
+    {
+        if (m_Ext == nullptr)
+        {
+            m_Ext = new Extension();
+        }
+
+        return *m_Ext;
+    }
+
+    JOB_TIME_TYPE Job::GetNextRun()
+    {
+        return GetNextRun(JobClock().Now());
+    }
+
+    JOB_TIME_TYPE Job::GetNextRun(JOB_TIME_TYPE now)
     {
         int interval = 1;
 
@@ -245,8 +853,8 @@ namespace Jobs
                 throw JobException("Latest Must Be Greater Then Or Equal To Interval");
             }
 
-            std::uniform_int_distribution<uint32_t> uintDist(m_Interval, m_Latest);
-            interval = uintDist(m_Gen);
+            std::uniform_int_distribution<int> intDist(m_Interval, m_Latest);
+            interval = intDist(t_Random);
         }
         else
         {
@@ -258,125 +866,219 @@ namespace Jobs
             throw JobException("Start Day Can Only Be Used With Weeks Unit");
         }
 
-        return CalcNextRun(interval);
+        m_NextRun = CalcNextRun(interval, now);
+        return m_NextRun;
     }
 
     void Job::RunEvery(int interval)
     {
+        if (interval <= 0 && (m_Ext == nullptr || m_Ext->cron == nullptr))
+        {
+            throw JobException("Interval Must Be Positive");
+        }
+
         m_Interval = interval;
     }
 
-    std::time_t Job::CalcNextRun(int interval) const
+    JOB_TIME_TYPE Job::FromTimeT(std::time_t time)
     {
-        std::tm* nextRun = GetLocalTime();
+        return Clock::System()->FromTimeT(time);
+    }
+
+    std::time_t Job::ToTimeT(JOB_TIME_TYPE time)
+    {
+        return Clock::System()->ToTimeT(time);
+    }
+
+    JOB_TIME_TYPE Job::CalcNextRun(int interval, JOB_TIME_TYPE now) const
+    {
+        // NOTE(yuval): Wall clock schedules are shifted by the job's dispersion offset every time, so the search
+        //              starts from the unshifted time (interval jobs keep the offset of their first run).
+        JOB_CLOCK_TYPE::duration offset = DispersionOffset();
+        std::time_t offsetSeconds = static_cast<std::time_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(offset).count());
+
+        if (m_Ext != nullptr && m_Ext->cron != nullptr)
+        {
+            // NOTE(yuval): Cron() made sure that the schedule matches, and a schedule that
+            //              matches once keeps matching, so the search never fails here.
+            // NOTE(yuval): The job might run slightly before its wall clock second starts,
+            //              so the search starts after the previously scheduled run as well.
+            const Clock& clock = JobClock();
+            std::time_t next = 0;
+            m_Ext->cron->Next(std::max(clock.WallTime() - offsetSeconds, m_Ext->lastCronRun), next);
+            m_Ext->lastCronRun = next;
+
+            return clock.FromTimeT(next) + offset;
+        }
+
+        // Wall clock arithmetic is only needed for schedules that are bound to a time of day
+        if (m_AtTime.isSet || m_StartDay != -1)
+        {
+            const Clock& clock = JobClock();
+            return clock.FromTimeT(CalcNextWallRun(interval, clock.WallTime() - offsetSeconds)) + offset;
+        }
+
+        JOB_CLOCK_TYPE::duration period = UnitDuration() * interval;
+
+        // The first run is scheduled relative to now
+        if (m_NextRun == JOB_TIME_TYPE() || period <= JOB_CLOCK_TYPE::duration::zero())
+        {
+            return now + period;
+        }
+
+        // NOTE(yuval): Later runs are scheduled relative to the previous run time, so a job that
+        //              completes late doesn't push all of its following runs back.
+        JOB_TIME_TYPE nextRun = m_NextRun + period;
+
+        if (nextRun <= now)
+        {
+            // Skipping the runs that were missed while keeping the job's phase
+            nextRun += period * ((now - nextRun) / period + 1);
+        }
+
+        return nextRun;
+    }
+
+    std::time_t Job::CalcNextWallRun(int interval, std::time_t now) const
+    {
+        // NOTE(yuval): The civil time conversions are plain arithmetic over a cached
+        //              transition table, so concurrent reschedules don't serialize on libc.
+        const TimeZone& zone = TimeZone::Local();
+        CivilTime nextRun = zone.ToCivil(now);
 
         switch (m_Unit)
         {
         case JobUnit::Seconds:
-            AdjustSeconds(interval, nextRun);
+            AdjustSeconds(interval, &nextRun);
             break;
 
         case JobUnit::Minutes:
-            AdjustMinutes(interval, nextRun);
+            AdjustMinutes(interval, &nextRun);
             break;
 
         case JobUnit::Hours:
-            AdjustHours(interval, nextRun);
+            AdjustHours(interval, &nextRun);
             break;
 
         case JobUnit::Days:
-            AdjustDays(interval, nextRun);
+            AdjustDays(interval, &nextRun);
             break;
 
         case JobUnit::Weeks:
-            AdjustWeeks(interval, nextRun);
+            AdjustWeeks(interval, &nextRun);
+            break;
+
+        default:
             break;
         }
 
-        return std::mktime(nextRun);
+        return zone.FromCivil(nextRun);
     }
 
-    void Job::AdjustSeconds(int interval, tm* nextRun) const
+    JOB_CLOCK_TYPE::duration Job::UnitDuration() const
     {
-        nextRun->tm_sec += interval;
+        switch (m_Unit)
+        {
+        case JobUnit::Microseconds:
+            return std::chrono::microseconds(1);
+
+        case JobUnit::Milliseconds:
+            return std::chrono::milliseconds(1);
+
+        case JobUnit::Minutes:
+            return std::chrono::minutes(1);
+
+        case JobUnit::Hours:
+            return std::chrono::hours(1);
+
+        case JobUnit::Days:
+            return std::chrono::hours(24);
+
+        case JobUnit::Weeks:
+            return std::chrono::hours(24 * 7);
+
+        case JobUnit::Seconds:
+        default:
+            return std::chrono::seconds(1);
+        }
+    }
+
+    void Job::AdjustSeconds(int interval, CivilTime* nextRun) const
+    {
+        nextRun->second += interval;
     }
 
-    void Job::AdjustMinutes(int interval, tm* nextRun) const
+    void Job::AdjustMinutes(int interval, CivilTime* nextRun) const
     {
         AtSecond(nextRun);
-        nextRun->tm_min += interval;
+        nextRun->minute += interval;
     }
 
-    void Job::AdjustHours(int interval, tm* nextRun) const
+    void Job::AdjustHours(int interval, CivilTime* nextRun) const
     {
         AtMinute(nextRun);
-        nextRun->tm_hour += interval;
+        nextRun->hour += interval;
     }
 
-    void Job::AdjustDays(int interval, tm* nextRun) const
+    void Job::AdjustDays(int interval, CivilTime* nextRun) const
     {
         AtTime(nextRun);
-        nextRun->tm_mday += interval;
+        nextRun->day += interval;
     }
 
-    void Job::AdjustWeeks(int interval, tm* nextRun) const
+    void Job::AdjustWeeks(int interval, CivilTime* nextRun) const
     {
         AtTime(nextRun);
 
         if (m_StartDay == -1)
         {
-            nextRun->tm_mday += interval * 7;
+            nextRun->day += interval * 7;
         }
         else
         {
-            int daysAhead = m_StartDay - nextRun->tm_wday + 1;
+            int daysAhead = m_StartDay - nextRun->weekDay + 1;
 
             if (daysAhead < 0)
             {
                 daysAhead += 7;
             }
 
-            nextRun->tm_mday += daysAhead;
+            nextRun->day += daysAhead;
         }
     }
 
-    void Job::AtTime(tm* nextRun) const
+    void Job::AtTime(CivilTime* nextRun) const
     {
         AtSecond(nextRun);
         AtMinute(nextRun);
         AtHour(nextRun);
     }
 
-    void Job::AtSecond(tm* nextRun) const
+    void Job::AtSecond(CivilTime* nextRun) const
     {
-        if (m_AtTime != nullptr)
+        if (m_AtTime.isSet)
         {
-            nextRun->tm_sec = m_AtTime->tm_sec;
+            nextRun->second = m_AtTime.second;
         }
     }
 
-    void Job::AtMinute(tm* nextRun) const
+    void Job::AtMinute(CivilTime* nextRun) const
     {
-        if (m_AtTime != nullptr)
+        if (m_AtTime.isSet)
         {
-            nextRun->tm_min = m_AtTime->tm_min;
+            nextRun->minute = m_AtTime.minute;
         }
     }
 
-    void Job::AtHour(tm* nextRun) const
+    void Job::AtHour(CivilTime* nextRun) const
     {
-        if (m_AtTime != nullptr)
+        if (m_AtTime.isSet)
         {
-            nextRun->tm_hour = m_AtTime->tm_hour;
+            nextRun->hour = m_AtTime.hour;
         }
     }
 
-    tm* Job::GetLocalTime()
-    {
-        std::time_t now = std::time(nullptr);
-        return localtime(&now);
-    }
-
     std::vector<std::string> Job::SplitString(const std::string& str, char delim)
     {
         std::vector<std::string> split;
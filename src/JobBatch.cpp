@@ -0,0 +1,75 @@
+#include "Jobs/JobBatch.h"
+#include "Jobs/Runner.h"
+#include <new>
+
+namespace Jobs
+{
+    namespace
+    {
+        // The number of jobs' storage that is allocated from the job pool at once
+        constexpr std::size_t STORAGE_BATCH_SIZE = 256;
+    }
+
+    JobBatch::JobBatch(Runner& runner)
+        : m_Runner(runner)
+    {
+    }
+
+    JobBatch::~JobBatch()
+    {
+        Discard();
+    }
+
+    Job& JobBatch::Every(int interval)
+    {
+        // NOTE(yuval): The storage is taken from the runner's job pool in batches, so creating
+        //              a job doesn't take the runner's lock.
+        if (m_Storage.empty())
+        {
+            m_Runner.AllocateJobs(STORAGE_BATCH_SIZE, m_Storage);
+        }
+
+        // The job isn't bound to the runner, so its Do doesn't add it
+        m_Jobs.push_back(nullptr);
+        Job* job = new (m_Storage.back()) Job(interval, nullptr);
+        job->m_Pooled = true;
+
+        m_Storage.pop_back();
+        m_Jobs.back() = job;
+
+        return *job;
+    }
+
+    std::vector<JobHandle> JobBatch::Commit()
+    {
+        for (Job* job : m_Jobs)
+        {
+            if (!job->JobFunc())
+            {
+                throw JobException("A Job In The Batch Has No Job Function");
+            }
+        }
+
+        std::vector<JobHandle> handles = m_Runner.AddJobs(m_Jobs);
+        m_Jobs.clear();
+
+        return handles;
+    }
+
+    void JobBatch::Discard()
+    {
+        for (Job* job : m_Jobs)
+        {
+            job->~Job();
+            m_Storage.push_back(job);
+        }
+
+        m_Jobs.clear();
+
+        if (!m_Storage.empty())
+        {
+            m_Runner.FreeJobs(m_Storage);
+            m_Storage.clear();
+        }
+    }
+}
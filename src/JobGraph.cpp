@@ -0,0 +1,343 @@
+#include "Jobs/JobGraph.h"
+#include "Jobs/Job.h"
+#include "Jobs/Runner.h"
+#include <algorithm>
+
+namespace Jobs
+{
+    namespace
+    {
+        // The state word of a graph: its iterations in flight, and whether all of its roots were retired
+        constexpr std::uint32_t RETIRED_BIT = 1u << 31;
+        constexpr std::uint32_t ITERATIONS_MASK = ~RETIRED_BIT;
+    }
+
+    // A single iteration of a graph, which frees itself once all of its jobs completed.
+    // NOTE(yuval): Every iteration has fan-in counters of its own, so the iterations of a graph can
+    //              overlap while the jobs of each iteration still run in order.
+    class JobGraph::Iteration
+    {
+    public:
+        Iteration(std::shared_ptr<JobGraph> graph, Runner* runner, std::uint32_t root)
+            : m_Graph(std::move(graph)), m_Runner(runner), m_Runs(new NodeRun[m_Graph->m_Jobs.size()]), m_Remaining(1)
+        {
+            // Counting the edges between the jobs that are reachable from the root
+            std::vector<std::uint32_t> stack(1, root);
+            m_Runs[root].reached = true;
+
+            while (!stack.empty())
+            {
+                std::uint32_t index = stack.back();
+                stack.pop_back();
+
+                for (std::uint32_t downstream : m_Graph->m_Downstream[index])
+                {
+                    NodeRun& run = m_Runs[downstream];
+                    run.pending.fetch_add(1, std::memory_order_relaxed);
+
+                    if (!run.reached)
+                    {
+                        run.reached = true;
+                        run.iteration = this;
+                        run.index = downstream;
+                        m_Remaining.fetch_add(1, std::memory_order_relaxed);
+                        stack.push_back(downstream);
+                    }
+                }
+            }
+        }
+
+        // Completes the job at the given index, starting the downstream jobs that no longer wait for anything.
+        // NOTE(yuval): The iteration must not be touched after this returns, it might already be gone.
+        void Finish(std::uint32_t index, bool threw)
+        {
+            std::uint32_t finished = 1;
+            std::vector<std::uint32_t> skipped;
+
+            for (;;)
+            {
+                for (std::uint32_t downstream : m_Graph->m_Downstream[index])
+                {
+                    NodeRun& run = m_Runs[downstream];
+
+                    // NOTE(yuval): The skip flag is published by the decrement below
+                    if (threw)
+                    {
+                        run.skip.store(true, std::memory_order_relaxed);
+                    }
+
+                    if (run.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    {
+                        continue;
+                    }
+
+                    if (run.skip.load(std::memory_order_relaxed))
+                    {
+                        skipped.push_back(downstream);
+                    }
+                    else
+                    {
+                        Job* job = m_Graph->m_Jobs[downstream];
+                        m_Runner->Submit(&run, job->GetPriority());
+                    }
+                }
+
+                // A skipped job skips its downstream jobs as well
+                if (skipped.empty())
+                {
+                    break;
+                }
+
+                index = skipped.back();
+                skipped.pop_back();
+                threw = true;
+                ++finished;
+            }
+
+            if (m_Remaining.fetch_sub(finished, std::memory_order_acq_rel) == finished)
+            {
+                std::shared_ptr<JobGraph> graph = std::move(m_Graph);
+                Runner* runner = m_Runner;
+                delete this;
+
+                graph->EndIteration(runner);
+            }
+        }
+
+    private:
+        // The run of a single job in the iteration
+        struct NodeRun : public Task
+        {
+            Iteration* iteration = nullptr;
+            std::uint32_t index = 0;
+            bool reached = false;
+            std::atomic<bool> skip{ false };
+            std::atomic<std::uint32_t> pending{ 0 }; // The upstream jobs that didn't complete yet
+
+            void Execute() override
+            {
+                Job* job = iteration->m_Graph->m_Jobs[index];
+                iteration->Finish(index, !job->RunDownstream());
+            }
+        };
+
+    private:
+        std::shared_ptr<JobGraph> m_Graph;
+        Runner* m_Runner;
+        std::unique_ptr<NodeRun[]> m_Runs;
+        std::atomic<std::uint32_t> m_Remaining; // The jobs that didn't complete yet, including the root
+    };
+
+    JobGraph::JobGraph()
+        : m_RetiredRoots(0), m_LastRoot(nullptr), m_MaxIterations(1), m_State(0)
+    {
+    }
+
+    void JobGraph::Connect(Job& upstream, Job& downstream)
+    {
+        if (&upstream == &downstream)
+        {
+            throw JobException("A Job Can't Run After Itself");
+        }
+
+        if (upstream.Handle().GetRunner() != downstream.Handle().GetRunner())
+        {
+            throw JobException("Jobs Of Different Runners Can't Be Chained");
+        }
+
+        if (!upstream.Handle().Empty() || !downstream.Handle().Empty())
+        {
+            throw JobException("Jobs Must Be Chained Before They Are Added");
+        }
+
+        JobGraph& graph = Of(upstream);
+        JobGraph& other = Of(downstream);
+
+        if (&graph != &other)
+        {
+            graph.Merge(other);
+        }
+
+        std::uint32_t from = upstream.GraphIndex();
+        std::uint32_t to = downstream.GraphIndex();
+        std::vector<std::uint32_t>& edges = graph.m_Downstream[from];
+
+        if (std::find(edges.begin(), edges.end(), to) != edges.end())
+        {
+            return;
+        }
+
+        if (graph.Reaches(to, from))
+        {
+            throw JobException("The Jobs Would Form A Cycle");
+        }
+
+        edges.push_back(to);
+        ++graph.m_UpstreamCount[to];
+    }
+
+    JobGraph& JobGraph::Of(Job& job)
+    {
+        JobGraph* graph = job.Graph();
+
+        if (graph == nullptr)
+        {
+            std::shared_ptr<JobGraph> created = std::make_shared<JobGraph>();
+            graph = created.get();
+            job.JoinGraph(std::move(created), graph->Add(job));
+        }
+
+        return *graph;
+    }
+
+    void JobGraph::MaxIterations(unsigned int limit)
+    {
+        if (limit == 0 || limit > ITERATIONS_MASK)
+        {
+            throw JobException("Invalid Iteration Limit");
+        }
+
+        m_MaxIterations = limit;
+    }
+
+    bool JobGraph::HasUpstream(std::uint32_t index) const
+    {
+        return m_UpstreamCount[index] != 0;
+    }
+
+    bool JobGraph::BeginIteration()
+    {
+        std::uint32_t current = m_State.load(std::memory_order_relaxed);
+
+        do
+        {
+            if ((current & ITERATIONS_MASK) >= m_MaxIterations)
+            {
+                return false;
+            }
+        } while (!m_State.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel));
+
+        return true;
+    }
+
+    void JobGraph::StartIteration(Job* root, bool threw)
+    {
+        Iteration* iteration = new Iteration(root->SharedGraph(), root->Handle().GetRunner(), root->GraphIndex());
+        iteration->Finish(root->GraphIndex(), threw);
+    }
+
+    bool JobGraph::RetireRoot(Job* root)
+    {
+        std::uint32_t index = root->GraphIndex();
+
+        if (m_RootRetired[index])
+        {
+            return true;
+        }
+
+        m_RootRetired[index] = true;
+        ++m_RetiredRoots;
+
+        // NOTE(yuval): The iterations of the other roots don't touch this one, only the jobs downstream of it
+        if (!Retired())
+        {
+            return true;
+        }
+
+        m_LastRoot = root;
+        return (m_State.fetch_or(RETIRED_BIT, std::memory_order_acq_rel) & ITERATIONS_MASK) == 0;
+    }
+
+    bool JobGraph::Retired() const
+    {
+        std::size_t roots = static_cast<std::size_t>(std::count(m_UpstreamCount.begin(), m_UpstreamCount.end(), 0u));
+        return m_RetiredRoots == roots;
+    }
+
+    void JobGraph::DownstreamJobs(std::vector<Job*>& jobs) const
+    {
+        for (std::size_t i = 0; i < m_Jobs.size(); ++i)
+        {
+            if (m_UpstreamCount[i] != 0)
+            {
+                jobs.push_back(m_Jobs[i]);
+            }
+        }
+    }
+
+    std::uint32_t JobGraph::Add(Job& job)
+    {
+        m_Jobs.push_back(&job);
+        m_Downstream.emplace_back();
+        m_UpstreamCount.push_back(0);
+        m_RootRetired.push_back(false);
+
+        return static_cast<std::uint32_t>(m_Jobs.size() - 1);
+    }
+
+    void JobGraph::Merge(JobGraph& other)
+    {
+        std::uint32_t offset = static_cast<std::uint32_t>(m_Jobs.size());
+        std::shared_ptr<JobGraph> self = m_Jobs.front()->SharedGraph();
+
+        // NOTE(yuval): The jobs hold the only references to the other graph, so it is kept alive until it was moved
+        std::shared_ptr<JobGraph> keepAlive = other.m_Jobs.front()->SharedGraph();
+
+        for (std::size_t i = 0; i < other.m_Jobs.size(); ++i)
+        {
+            Job* job = other.m_Jobs[i];
+            m_Jobs.push_back(job);
+            m_Downstream.emplace_back(std::move(other.m_Downstream[i]));
+            m_UpstreamCount.push_back(other.m_UpstreamCount[i]);
+            m_RootRetired.push_back(false);
+
+            for (std::uint32_t& downstream : m_Downstream.back())
+            {
+                downstream += offset;
+            }
+
+            job->JoinGraph(self, offset + static_cast<std::uint32_t>(i));
+        }
+
+        m_MaxIterations = std::max(m_MaxIterations, other.m_MaxIterations);
+    }
+
+    bool JobGraph::Reaches(std::uint32_t from, std::uint32_t to) const
+    {
+        std::vector<bool> visited(m_Jobs.size(), false);
+        std::vector<std::uint32_t> stack(1, from);
+        visited[from] = true;
+
+        while (!stack.empty())
+        {
+            std::uint32_t index = stack.back();
+            stack.pop_back();
+
+            if (index == to)
+            {
+                return true;
+            }
+
+            for (std::uint32_t downstream : m_Downstream[index])
+            {
+                if (!visited[downstream])
+                {
+                    visited[downstream] = true;
+                    stack.push_back(downstream);
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void JobGraph::EndIteration(Runner* runner)
+    {
+        // The last iteration of a graph whose roots were all retired hands the last root back to the runner,
+        // which destroys it along with the graph's jobs
+        if (m_State.fetch_sub(1, std::memory_order_acq_rel) == (RETIRED_BIT | 1))
+        {
+            runner->AddJob(JOB_TIME_TYPE(), m_LastRoot);
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#include "Jobs/JobPool.h"
+#include "Jobs/Job.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace Jobs
+{
+    namespace
+    {
+        constexpr std::size_t RoundUp(std::size_t size, std::size_t alignment)
+        {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        constexpr std::size_t RoundUpToPowerOfTwo(std::size_t size)
+        {
+            std::size_t powerOfTwo = 1;
+
+            while (powerOfTwo < size)
+            {
+                powerOfTwo <<= 1;
+            }
+
+            return powerOfTwo;
+        }
+
+        constexpr std::size_t ITEM_ALIGNMENT = alignof(Job) > alignof(void*) ? alignof(Job) : alignof(void*);
+        constexpr std::size_t ITEM_SIZE = RoundUp(sizeof(Job) > sizeof(void*) ? sizeof(Job) : sizeof(void*),
+                                                  ITEM_ALIGNMENT);
+        constexpr std::size_t FIRST_ITEM_OFFSET = RoundUp(sizeof(std::size_t), ITEM_ALIGNMENT);
+
+        // NOTE(yuval): Slabs are aligned to their size (a power of two that fits at least 64 jobs),
+        //              so the slab of an item is found by masking its address.
+        constexpr std::size_t MIN_SLAB_SIZE = 64 * 1024;
+        constexpr std::size_t SLAB_SIZE = RoundUpToPowerOfTwo(FIRST_ITEM_OFFSET + 64 * ITEM_SIZE) > MIN_SLAB_SIZE ?
+                                          RoundUpToPowerOfTwo(FIRST_ITEM_OFFSET + 64 * ITEM_SIZE) : MIN_SLAB_SIZE;
+        constexpr std::size_t ITEMS_PER_SLAB = (SLAB_SIZE - FIRST_ITEM_OFFSET) / ITEM_SIZE;
+    }
+
+    JobPool::JobPool()
+        : m_FreeItems(nullptr)
+    {
+    }
+
+    JobPool::~JobPool()
+    {
+        for (Slab* slab : m_Slabs)
+        {
+            ::operator delete(slab, std::align_val_t(SLAB_SIZE));
+        }
+    }
+
+    void* JobPool::Allocate()
+    {
+        if (m_FreeItems == nullptr)
+        {
+            AddSlab();
+        }
+
+        FreeItem* item = m_FreeItems;
+        m_FreeItems = item->next;
+        ++SlabOf(item)->liveCount;
+
+        return item;
+    }
+
+    void JobPool::Free(void* storage)
+    {
+        --SlabOf(storage)->liveCount;
+
+        FreeItem* item = static_cast<FreeItem*>(storage);
+        item->next = m_FreeItems;
+        m_FreeItems = item;
+    }
+
+    void JobPool::Trim()
+    {
+        // Unlinking the free items of the slabs that are about to be released
+        FreeItem** link = &m_FreeItems;
+
+        while (*link != nullptr)
+        {
+            if (SlabOf(*link)->liveCount == 0)
+            {
+                *link = (*link)->next;
+            }
+            else
+            {
+                link = &(*link)->next;
+            }
+        }
+
+        std::vector<Slab*>::iterator liveEnd = std::remove_if(m_Slabs.begin(), m_Slabs.end(), [](Slab* slab)
+        {
+            if (slab->liveCount != 0)
+            {
+                return false;
+            }
+
+            ::operator delete(slab, std::align_val_t(SLAB_SIZE));
+            return true;
+        });
+
+        m_Slabs.erase(liveEnd, m_Slabs.end());
+    }
+
+    void JobPool::AddSlab()
+    {
+        Slab* slab = new (::operator new(SLAB_SIZE, std::align_val_t(SLAB_SIZE))) Slab{ 0 };
+        m_Slabs.push_back(slab);
+
+        // Pushing the items in reverse, so jobs are handed out in address order
+        char* items = reinterpret_cast<char*>(slab) + FIRST_ITEM_OFFSET;
+
+        for (std::size_t i = ITEMS_PER_SLAB; i > 0; --i)
+        {
+            FreeItem* item = reinterpret_cast<FreeItem*>(items + (i - 1) * ITEM_SIZE);
+            item->next = m_FreeItems;
+            m_FreeItems = item;
+        }
+    }
+
+    JobPool::Slab* JobPool::SlabOf(void* item)
+    {
+        return reinterpret_cast<Slab*>(reinterpret_cast<std::uintptr_t>(item) & ~(SLAB_SIZE - 1));
+    }
+}
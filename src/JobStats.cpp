@@ -0,0 +1,160 @@
+#include "Jobs/JobStats.h"
+#include "Jobs/Bits.h"
+
+namespace Jobs
+{
+    namespace
+    {
+        // Bumps a counter that only one thread writes, unless concurrent is set
+        template <typename T>
+        inline void Increment(std::atomic<T>& counter, T amount, bool concurrent)
+        {
+            if (concurrent)
+            {
+                counter.fetch_add(amount, std::memory_order_relaxed);
+            }
+            else
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::chrono::microseconds HistogramSnapshot::Mean() const
+    {
+        return count == 0 ? std::chrono::microseconds(0) : sum / static_cast<std::int64_t>(count);
+    }
+
+    std::chrono::microseconds HistogramSnapshot::Percentile(double fraction) const
+    {
+        if (count == 0)
+        {
+            return std::chrono::microseconds(0);
+        }
+
+        std::uint64_t target = static_cast<std::uint64_t>(fraction * static_cast<double>(count));
+        std::uint64_t seen = 0;
+
+        for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+        {
+            seen += buckets[bucket];
+
+            if (seen > target || seen == count)
+            {
+                // The end of the bucket (the max for the last non empty one)
+                std::chrono::microseconds end = bucket + 1 < BUCKET_COUNT ? BucketStart(bucket + 1) - std::chrono::microseconds(1) : max;
+                return end < max ? end : max;
+            }
+        }
+
+        return max;
+    }
+
+    std::chrono::microseconds HistogramSnapshot::BucketStart(std::size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+        {
+            return std::chrono::microseconds(bucket);
+        }
+
+        std::size_t octave = bucket / SUB_BUCKETS + 1;
+        std::size_t subBucket = bucket % SUB_BUCKETS;
+
+        return std::chrono::microseconds(static_cast<std::int64_t>((SUB_BUCKETS + subBucket) << (octave - 2)));
+    }
+
+    std::size_t HistogramSnapshot::BucketOf(std::chrono::microseconds duration)
+    {
+        if (duration.count() < static_cast<std::int64_t>(SUB_BUCKETS))
+        {
+            return duration.count() < 0 ? 0 : static_cast<std::size_t>(duration.count());
+        }
+
+        // The power of two range picks the octave, and the next two bits pick the bucket within it
+        std::uint64_t value = static_cast<std::uint64_t>(duration.count());
+        std::size_t octave = HighestSetBit(value);
+        std::size_t bucket = (octave - 1) * SUB_BUCKETS + ((value >> (octave - 2)) & (SUB_BUCKETS - 1));
+
+        return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+    }
+
+    DurationHistogram::DurationHistogram()
+        : m_Sum(0), m_Max(0)
+    {
+        for (std::atomic<std::uint32_t>& bucket : m_Buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void DurationHistogram::Record(std::chrono::microseconds duration, bool concurrent)
+    {
+        std::int64_t value = duration.count() < 0 ? 0 : duration.count();
+
+        Increment(m_Buckets[HistogramSnapshot::BucketOf(std::chrono::microseconds(value))], std::uint32_t(1), concurrent);
+        Increment(m_Sum, value, concurrent);
+
+        std::int64_t max = m_Max.load(std::memory_order_relaxed);
+
+        while (value > max && !m_Max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    HistogramSnapshot DurationHistogram::Snapshot() const
+    {
+        HistogramSnapshot snapshot;
+        snapshot.count = 0;
+
+        // NOTE(yuval): The count is summed from the buckets, so it always agrees with them
+        for (std::size_t bucket = 0; bucket < HistogramSnapshot::BUCKET_COUNT; ++bucket)
+        {
+            snapshot.buckets[bucket] = m_Buckets[bucket].load(std::memory_order_relaxed);
+            snapshot.count += snapshot.buckets[bucket];
+        }
+
+        snapshot.sum = std::chrono::microseconds(m_Sum.load(std::memory_order_relaxed));
+        snapshot.max = std::chrono::microseconds(m_Max.load(std::memory_order_relaxed));
+
+        return snapshot;
+    }
+
+    JobStats::JobStats(bool concurrent)
+        : m_Concurrent(concurrent), m_ScheduledTime(0), m_DispatchTime(0), m_RunCount(0), m_ExceptionCount(0)
+    {
+    }
+
+    void JobStats::RecordRun(std::chrono::steady_clock::time_point startTime,
+                             std::chrono::steady_clock::time_point endTime, bool threw)
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using TimePoint = std::chrono::steady_clock::time_point;
+
+        TimePoint scheduledTime(TimePoint::duration(m_ScheduledTime.load(std::memory_order_relaxed)));
+        TimePoint dispatchTime(TimePoint::duration(m_DispatchTime.load(std::memory_order_relaxed)));
+
+        m_StartLag.Record(duration_cast<microseconds>(startTime - scheduledTime), m_Concurrent);
+        m_QueueWait.Record(duration_cast<microseconds>(startTime - dispatchTime), m_Concurrent);
+        m_RunDuration.Record(duration_cast<microseconds>(endTime - startTime), m_Concurrent);
+
+        Increment(m_RunCount, std::uint64_t(1), m_Concurrent);
+
+        if (threw)
+        {
+            Increment(m_ExceptionCount, std::uint64_t(1), m_Concurrent);
+        }
+    }
+
+    JobStatsSnapshot JobStats::Snapshot() const
+    {
+        JobStatsSnapshot snapshot;
+        snapshot.runCount = m_RunCount.load(std::memory_order_relaxed);
+        snapshot.exceptionCount = m_ExceptionCount.load(std::memory_order_relaxed);
+        snapshot.startLag = m_StartLag.Snapshot();
+        snapshot.queueWait = m_QueueWait.Snapshot();
+        snapshot.runDuration = m_RunDuration.Snapshot();
+
+        return snapshot;
+    }
+}
@@ -0,0 +1,27 @@
+#include "Jobs/JobStore.h"
+#include "Jobs/MultiMapJobStore.h"
+#include "Jobs/TimingWheelJobStore.h"
+
+namespace Jobs
+{
+    std::unique_ptr<JobStore> JobStore::Create(JobStoreType::Type type, JOB_TIME_TYPE now)
+    {
+        switch (type)
+        {
+        case JobStoreType::TimingWheel:
+            return std::unique_ptr<JobStore>(new TimingWheelJobStore(now));
+
+        case JobStoreType::MultiMap:
+        default:
+            return std::unique_ptr<JobStore>(new MultiMapJobStore());
+        }
+    }
+
+    void JobStore::InsertBatch(std::vector<Entry>& entries)
+    {
+        for (const Entry& entry : entries)
+        {
+            Insert(entry.first, entry.second);
+        }
+    }
+}
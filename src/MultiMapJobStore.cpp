@@ -0,0 +1,178 @@
+#include "Jobs/MultiMapJobStore.h"
+#include <algorithm>
+
+namespace Jobs
+{
+    void MultiMapJobStore::Insert(JOB_TIME_TYPE time, Job* job)
+    {
+        std::uint32_t slot = job->Handle().Index();
+
+        if (slot >= m_Entries.size())
+        {
+            m_Entries.resize(slot + 1, m_Jobs.end());
+        }
+
+        // Re-inserting a stored job moves its node to the new run time
+        if (m_Entries[slot] != m_Jobs.end())
+        {
+            JOB_MAP_TYPE::node_type node = m_Jobs.extract(m_Entries[slot]);
+            node.key() = time;
+            m_Entries[slot] = m_Jobs.insert(std::move(node));
+            return;
+        }
+
+        m_Entries[slot] = Emplace(time, job);
+    }
+
+    void MultiMapJobStore::InsertBatch(std::vector<Entry>& entries)
+    {
+        if (entries.empty())
+        {
+            return;
+        }
+
+        // Growing the entry table once for the whole batch
+        std::uint32_t maxSlot = 0;
+
+        for (const Entry& entry : entries)
+        {
+            maxSlot = std::max(maxSlot, entry.second->Handle().Index());
+        }
+
+        if (maxSlot >= m_Entries.size())
+        {
+            m_Entries.resize(maxSlot + 1, m_Jobs.end());
+        }
+
+        // NOTE(yuval): The batch is inserted from the latest job to the earliest, each one right before
+        //              the previous one, so the map is built without searching it (unless the batch
+        //              interleaves with jobs that are already stored).
+        std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs)
+        {
+            return lhs.first < rhs.first;
+        });
+
+        JOB_MAP_ITER hint = m_Jobs.upper_bound(entries.back().first);
+
+        for (auto entry = entries.rbegin(); entry != entries.rend(); ++entry)
+        {
+            hint = Emplace(hint, entry->first, entry->second);
+            m_Entries[entry->second->Handle().Index()] = hint;
+        }
+    }
+
+    bool MultiMapJobStore::Remove(Job* job)
+    {
+        std::uint32_t slot = job->Handle().Index();
+
+        // If the job isn't stored there is nothing to remove
+        if (slot >= m_Entries.size() || m_Entries[slot] == m_Jobs.end())
+        {
+            return false;
+        }
+
+        m_FreeNodes.push_back(m_Jobs.extract(m_Entries[slot]));
+        m_Entries[slot] = m_Jobs.end();
+        return true;
+    }
+
+    void MultiMapJobStore::PopExpired(JOB_TIME_TYPE now, std::vector<Job*>& expired)
+    {
+        while (!m_Jobs.empty() && m_Jobs.begin()->first <= now)
+        {
+            Job* job = m_Jobs.begin()->second;
+
+            expired.push_back(job);
+            m_FreeNodes.push_back(m_Jobs.extract(m_Jobs.begin()));
+            m_Entries[job->Handle().Index()] = m_Jobs.end();
+        }
+    }
+
+    void MultiMapJobStore::PopAll(std::vector<Job*>& jobs)
+    {
+        while (!m_Jobs.empty())
+        {
+            Job* job = m_Jobs.begin()->second;
+
+            jobs.push_back(job);
+            m_FreeNodes.push_back(m_Jobs.extract(m_Jobs.begin()));
+            m_Entries[job->Handle().Index()] = m_Jobs.end();
+        }
+    }
+
+    Job* MultiMapJobStore::Find(const std::function<bool(Job*)>& pred) const
+    {
+        for (const JOB_MAP_TYPE::value_type& element : m_Jobs)
+        {
+            if (pred(element.second))
+            {
+                return element.second;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool MultiMapJobStore::NextRunTime(JOB_TIME_TYPE& time) const
+    {
+        if (m_Jobs.empty())
+        {
+            return false;
+        }
+
+        time = m_Jobs.begin()->first;
+        return true;
+    }
+
+    std::size_t MultiMapJobStore::Size() const
+    {
+        return m_Jobs.size();
+    }
+
+    void MultiMapJobStore::Reserve(std::size_t jobCount)
+    {
+        m_Entries.reserve(jobCount);
+        m_FreeNodes.reserve(jobCount);
+
+        // NOTE(yuval): Node handles can only be taken out of a map, so the nodes are allocated
+        //              through m_Jobs and extracted right away.
+        std::size_t nodeCount = m_Jobs.size() + m_FreeNodes.size();
+
+        for (; nodeCount < jobCount; ++nodeCount)
+        {
+            m_FreeNodes.push_back(m_Jobs.extract(m_Jobs.emplace(JOB_TIME_TYPE(), nullptr)));
+        }
+    }
+
+    JOB_MAP_ITER MultiMapJobStore::Emplace(JOB_TIME_TYPE time, Job* job)
+    {
+        if (m_FreeNodes.empty())
+        {
+            return m_Jobs.emplace(time, job);
+        }
+
+        JOB_MAP_TYPE::node_type node = std::move(m_FreeNodes.back());
+        m_FreeNodes.pop_back();
+
+        node.key() = time;
+        node.mapped() = job;
+
+        return m_Jobs.insert(std::move(node));
+    }
+
+    JOB_MAP_ITER MultiMapJobStore::Emplace(JOB_MAP_ITER hint, JOB_TIME_TYPE time, Job* job)
+    {
+        if (m_FreeNodes.empty())
+        {
+            return m_Jobs.emplace_hint(hint, time, job);
+        }
+
+        JOB_MAP_TYPE::node_type node = std::move(m_FreeNodes.back());
+        m_FreeNodes.pop_back();
+
+        node.key() = time;
+        node.mapped() = job;
+
+        return m_Jobs.insert(hint, std::move(node));
+    }
+}
@@ -1,177 +1,621 @@
 #include "Jobs/Runner.h"
+#include "Jobs/Bits.h"
 #include "Jobs/Job.h"
+#include "Jobs/JobGraph.h"
 #include <algorithm>
 #include <ctime>
-
-#define GET_FN_ADDR(fn) *(long*)(char*)&fn
+#include <exception>
+#include <new>
 
 namespace Jobs
 {
-    Runner::Runner(unsigned int maxJobs)
-        : m_IsRunning(false), m_Threads(maxJobs + 1)
+    namespace
+    {
+        // Batches are split over several threads once every thread gets at least this many jobs
+        constexpr std::size_t PARALLEL_BATCH_SIZE = 64 * 1024;
+
+        // Calls fn(begin, end) over chunks of [0, count), on several threads if the count is large enough
+        template <typename F>
+        void ParallelFor(std::size_t count, F&& fn)
+        {
+            std::size_t threadCount = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                                                            count / PARALLEL_BATCH_SIZE);
+
+            if (threadCount <= 1)
+            {
+                fn(std::size_t(0), count);
+                return;
+            }
+
+            std::size_t chunkSize = (count + threadCount - 1) / threadCount;
+            std::vector<std::exception_ptr> errors(threadCount);
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount - 1);
+
+            // The calling thread takes the first chunk
+            for (std::size_t i = 1; i < threadCount; ++i)
+            {
+                threads.emplace_back([&fn, &errors, i, chunkSize, count]
+                {
+                    try
+                    {
+                        fn(i * chunkSize, std::min(count, (i + 1) * chunkSize));
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
+                    }
+                });
+            }
+
+            try
+            {
+                fn(std::size_t(0), chunkSize);
+            }
+            catch (...)
+            {
+                errors[0] = std::current_exception();
+            }
+
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+
+            for (const std::exception_ptr& error : errors)
+            {
+                if (error != nullptr)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+        // Hashes a string with FNV-1a, which (unlike std::hash) hashes it the same in every build
+        std::uint64_t HashString(const std::string& str)
+        {
+            std::uint64_t hash = 14695981039346656037ull;
+
+            for (char c : str)
+            {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+            }
+
+            return hash;
+        }
+    }
+
+    Runner::Runner(unsigned int maxJobs, JobStoreType::Type storeType, ExecutorType::Type executorType)
+        : Runner(Executor::Create(executorType, maxJobs), storeType)
+    {
+    }
+
+    Runner::Runner(std::shared_ptr<Executor> executor, JobStoreType::Type storeType, std::shared_ptr<Clock> clock)
+        : m_IsRunning(false), m_IsEmbedded(false), m_Clock(clock != nullptr ? std::move(clock) : Clock::System()),
+          m_Lifetime(std::make_shared<RunnerLifetime>(this)), m_Jobs(JobStore::Create(storeType, m_Clock->Now())), m_FreeSlots(NO_SLOT), m_Inbox(nullptr),
+          m_WakeupDeadline(AWAKE), m_Sleeper(m_Clock.get()), m_Executor(std::move(executor)),
+          m_DispersionWindow(Clock::Duration::zero()), m_DispersionSeed(0), m_ThrottleJobs(0), m_ThrottleTick(Clock::Duration::zero()),
+          m_TickStart(), m_TickBudget(0), m_BacklogHead(0), m_CatchUp(CatchUpPolicy::Skip), m_LastMetricsTime(), m_LastJobsFired(0)
     {
+        // Every class runs on the runner's executor until it is given a lane of its own
+        m_LaneExecutors.fill(m_Executor.get());
     }
 
     Runner::~Runner()
     {
+        StopExportingMetrics();
+
         if (m_IsRunning)
         {
             Stop();
         }
 
         Clear();
+
+        // NOTE(yuval): Completions that come after this don't resume their jobs, since the executors
+        //              they would be submitted to are shut down below.
+        m_Lifetime->End();
+
+        // NOTE(yuval): Running jobs push themselves to the inbox once they complete, so an executor
+        //              that isn't shared has to finish them before the canceled jobs are destroyed.
+        ForEachExecutor([](const std::shared_ptr<Executor>& executor, long references)
+        {
+            if (executor.use_count() == references)
+            {
+                executor->Shutdown();
+            }
+        });
+
+        // NOTE(yuval): The tasks that still wait for their time are run right away, so the coroutine
+        //              jobs that sleep wake up (their sleep throws) and complete before they are destroyed.
+        std::vector<Timer> timers;
+
+        for (;;)
+        {
+            {
+                std::lock_guard<TimedMutex> lock(m_Mutex);
+
+                if (m_Timers.empty())
+                {
+                    break;
+                }
+
+                timers.swap(m_Timers);
+            }
+
+            for (const Timer& timer : timers)
+            {
+                timer.task->Execute();
+            }
+
+            timers.clear();
+        }
+
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        DrainInbox();
     }
 
     void Runner::Run()
     {
-        if (m_IsRunning)
+        if (m_IsEmbedded)
+        {
+            throw JobException("The Runner Is Driven By An Event Loop");
+        }
+
+        if (m_IsRunning.exchange(true))
         {
             return;
         }
 
-        m_IsRunning = true;
+        // NOTE(yuval): The run loop gets a thread of its own, so it never takes a worker away from the jobs
+        m_TimerThread = std::thread(&Runner::RunLoop, this);
+    }
+
+    void Runner::Stop()
+    {
+        m_IsRunning = false;
+        m_Sleeper.Interrupt();
+
+        if (m_TimerThread.joinable())
+        {
+            if (m_TimerThread.get_id() == std::this_thread::get_id())
+            {
+                m_TimerThread.detach();
+            }
+            else
+            {
+                m_TimerThread.join();
+            }
+        }
+    }
+
+    JobHandle Runner::AddJob(JOB_TIME_TYPE time, Job* job)
+    {
+        if (job == nullptr)
+        {
+            return JobHandle();
+        }
+
+        // Binding new jobs to a slot, rescheduled jobs already have one
+        if (job->m_Handle.GetRunner() != this || job->m_Handle.Empty())
+        {
+            std::lock_guard<TimedMutex> lock(m_Mutex);
+            job->m_Handle = AcquireSlot(job);
+            m_Slots[job->m_Handle.Index()].state = SlotRunning;
+
+            // NOTE(yuval): Only the first run is shifted, the following runs are computed from it
+            //              (or shifted again, for wall clock schedules), so the job keeps its period.
+            time += DispersionOffset(*job);
+        }
+
+        // NOTE(yuval): The handle is copied before the job is pushed, since the timer thread
+        //              might run or destroy the job as soon as it is in the inbox.
+        JobHandle handle = job->m_Handle;
+        PushInbox(time, job);
+
+        return handle;
+    }
+
+    std::vector<JobHandle> Runner::AddJobs(const std::vector<Job*>& jobs)
+    {
+        std::vector<JobHandle> handles;
+
+        if (jobs.empty())
+        {
+            return handles;
+        }
+
+        bool restoring;
+
+        {
+            std::lock_guard<TimedMutex> lock(m_Mutex);
+            restoring = !m_SnapshotRecords.empty();
+        }
 
-        m_Threads.push([this](int)
+        // Computing the first run times without holding the lock (restored jobs take theirs from the snapshot)
+        std::vector<JobStore::Entry> entries(jobs.size());
+
+        ParallelFor(jobs.size(), [this, &jobs, &entries, restoring](std::size_t begin, std::size_t end)
         {
-            while (m_IsRunning)
+            for (std::size_t i = begin; i < end; ++i)
             {
-                if (m_Jobs.empty())
+                Job* job = jobs[i];
+
+                if (!job->m_Handle.Empty())
                 {
-                    m_Sleeper.Sleep();
+                    throw JobException("The Job Was Already Added");
                 }
-                else
+
+                if (job->Graph() != nullptr && job->Graph()->HasUpstream(job->GraphIndex()))
                 {
-                    std::time_t firstTaskTime = m_Jobs.begin()->first;
-                    m_Sleeper.SleepUntil(firstTaskTime);
+                    throw JobException("A Job That Runs After Other Jobs Can't Be Added");
                 }
 
-                RunPending();
+                job->m_Handle = JobHandle(this, 0, 0);
+                job->AllocateStats();
+                entries[i].second = job;
+
+                if (!restoring || job->GetId() == 0)
+                {
+                    entries[i].first = job->GetNextRun();
+                }
             }
         });
+
+        // Binding the jobs to slots and building the time index in one pass
+        handles.reserve(jobs.size());
+        JOB_TIME_TYPE firstRun = JOB_TIME_TYPE::max();
+
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+
+        // NOTE(yuval): The restored jobs are resolved before any job is bound, so a job that throws leaves none behind
+        if (restoring)
+        {
+            for (JobStore::Entry& entry : entries)
+            {
+                if (entry.second->GetId() != 0 && !RestoreRunLocked(entry.second, entry.first))
+                {
+                    entry.first = entry.second->GetNextRun();
+                }
+            }
+        }
+
+        // Growing the slot table once for the whole batch
+        if (m_Slots.capacity() < m_Slots.size() + entries.size())
+        {
+            m_Slots.reserve(std::max(m_Slots.size() + entries.size(), m_Slots.capacity() * 2));
+        }
+
+        for (JobStore::Entry& entry : entries)
+        {
+            Job* job = entry.second;
+            job->m_Handle = AcquireSlot(job);
+            entry.first += DispersionOffset(*job);
+            job->m_NextRun = entry.first;
+
+            handles.push_back(job->m_Handle);
+            firstRun = std::min(firstRun, entry.first);
+        }
+
+        m_Jobs->InsertBatch(entries);
+
+        // NOTE(yuval): The timer thread publishes its deadline while holding m_Mutex, like for SubmitAt
+        if (firstRun.time_since_epoch().count() < m_WakeupDeadline.load())
+        {
+            m_Sleeper.Interrupt();
+        }
+
+        return handles;
     }
 
-    void Runner::Stop()
+    void Runner::RunPending()
     {
-        m_IsRunning = false;
-        m_Sleeper.Interrupt();
+        RunExpired();
+    }
+
+    void Runner::RunAll()
+    {
+        RunExpired(true);
     }
 
-    void Runner::AddJob(std::time_t time, Job* job)
+    void Runner::AdvanceClock(Clock::Duration duration)
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        VirtualClock* clock = dynamic_cast<VirtualClock*>(m_Clock.get());
 
-        // If the job exists, then adding it to the jobs map and interrupting the sleeper
-        if (job != nullptr)
+        if (clock == nullptr)
         {
-            m_Jobs.emplace(time, job);
-            m_Sleeper.Interrupt();
+            throw JobException("Only A Virtual Clock Can Be Advanced");
         }
+
+        JOB_TIME_TYPE target = clock->Now() + duration;
+        JOB_TIME_TYPE nextRunTime;
+
+        // Stepping from one run time to the next, the jobs that run at every step are already
+        // rescheduled (if they completed) when the next step looks for the following run time
+        while (NextWakeupTime(nextRunTime) && nextRunTime <= target)
+        {
+            clock->AdvanceTo(nextRunTime);
+            RunExpired();
+        }
+
+        clock->AdvanceTo(target);
+        RunExpired();
     }
 
-    void Runner::RunPending()
+    void Runner::Reserve(std::size_t jobCount)
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        JOB_MAP_ITER jobsToRunEnd = m_Jobs.upper_bound(std::time(nullptr));
+        {
+            std::lock_guard<std::mutex> runLock(m_RunMutex);
+            m_JobsToRun.reserve(jobCount);
+        }
 
-        // There are no pending jobs
-        if (jobsToRunEnd == m_Jobs.begin())
         {
-            return;
+            std::lock_guard<TimedMutex> lock(m_Mutex);
+
+            m_Slots.reserve(jobCount);
+            m_Jobs->Reserve(jobCount);
         }
 
-        // Running all the panding jobs
-        for (JOB_MAP_ITER i = m_Jobs.begin(); i != jobsToRunEnd; ++i)
+        ForEachExecutor([jobCount](const std::shared_ptr<Executor>& executor, long)
+        {
+            executor->Reserve(jobCount);
+        });
+    }
+
+    void Runner::SetLane(JobPriority::Class priority, std::shared_ptr<Executor> executor)
+    {
+        if (executor == m_Executor)
         {
-            RunJob(i->second);
+            executor = nullptr;
         }
 
-        // Removing the completed jobs
-        m_Jobs.erase(m_Jobs.begin(), jobsToRunEnd);
+        m_Lanes[priority] = std::move(executor);
+        m_LaneExecutors[priority] = m_Lanes[priority] != nullptr ? m_Lanes[priority].get() : m_Executor.get();
+    }
 
-        // NOTE(yuval): The lock_guard that was initialized in the beggining of the method
-        //              will make sure that the jobs will be re-added only after they are removed.
+    void Runner::Disperse(Clock::Duration window, std::uint32_t seed)
+    {
+        m_DispersionWindow = window;
+        m_DispersionSeed = seed;
     }
 
-    void Runner::RunAll()
+    Clock::Duration Runner::DispersionOffset(const Job& job) const
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        const JobHandle& handle = job.Handle();
+
+        if (m_DispersionWindow <= Clock::Duration::zero() || handle.GetRunner() != this || handle.Empty())
+        {
+            return Clock::Duration::zero();
+        }
 
-        for (const std::pair<std::time_t, Job*>& elem : m_Jobs)
+        // NOTE(yuval): A job's name or id is the same after a restart, so its offset is too. Other jobs are
+        //              keyed by their handle, whose generation tells apart the jobs that reuse a slot.
+        std::uint64_t key;
+
+        if (!job.GetName().empty())
+        {
+            key = HashString(job.GetName());
+        }
+        else if (job.GetId() != 0)
+        {
+            key = job.GetId();
+        }
+        else
         {
-            RunJob(elem.second);
+            key = MixBits((static_cast<std::uint64_t>(handle.Generation()) << 32) | handle.Index()) + m_DispersionSeed;
         }
 
-        // Removing all the jobs
-        m_Jobs.clear();
+        // The key is hashed, so jobs that were added one after another land far apart
+        std::uint64_t hash = MixBits(key);
+        return Clock::Duration(static_cast<Clock::Duration::rep>(
+            hash % static_cast<std::uint64_t>(m_DispersionWindow.count())));
+    }
+
+    void Runner::ThrottleDispatch(std::size_t maxJobs, Clock::Duration tick)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+
+        m_ThrottleJobs = maxJobs;
+        m_ThrottleTick = tick;
+        m_TickStart = JOB_TIME_TYPE();
+        m_TickBudget = 0;
+        m_Sleeper.Interrupt();
+    }
+
+    void Runner::Submit(Task* task)
+    {
+        m_Executor->Submit(task);
+    }
+
+    void Runner::Submit(Task* task, JobPriority::Class priority)
+    {
+        m_LaneExecutors[priority]->Submit(task);
+    }
+
+    void Runner::SubmitAt(JOB_TIME_TYPE time, Task* task, JobPriority::Class priority)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+
+        m_Timers.push_back(Timer{ time, task, priority });
+        std::push_heap(m_Timers.begin(), m_Timers.end(), TimerLater);
 
-        // NOTE(yuval): The lock_guard that was initialized in the beggining of the method
-        //              will make sure that the jobs will be re-added only after they are removed.
+        // NOTE(yuval): The timer thread publishes its deadline while holding m_Mutex,
+        //              so it either sees the timer or we see the deadline.
+        if (time.time_since_epoch().count() < m_WakeupDeadline.load())
+        {
+            m_Sleeper.Interrupt();
+        }
     }
 
     void Runner::Clear()
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        Job* currJob = nullptr;
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        DrainInbox();
+
+        // NOTE(yuval): The scratch buffer might be in use by a run that is dispatching its jobs
+        std::vector<Job*> jobs;
+        m_Jobs->PopAll(jobs);
+
+        // Jobs that still have runs in flight are canceled below
+        for (Job* currJob : jobs)
+        {
+            if (!DestroyStoredJob(currJob))
+            {
+                m_Slots[currJob->m_Handle.Index()].state = SlotRunning;
+            }
+        }
 
-        for (JOB_MAP_ITER i = m_Jobs.begin(); i != m_Jobs.end(); i++)
+        // Jobs that wait for the dispatch throttle weren't dispatched yet
+        for (std::size_t i = m_BacklogHead; i < m_Backlog.size(); ++i)
         {
-            currJob = i->second;
+            DestroyStoredJob(m_Backlog[i]);
+        }
 
-            if (currJob != nullptr)
+        m_Backlog.clear();
+        m_BacklogHead = 0;
+
+        // Jobs that are running right now are destroyed once they complete
+        for (JobSlot& slot : m_Slots)
+        {
+            if (slot.state == SlotRunning && !slot.canceled)
             {
-                delete currJob;
-                currJob = nullptr;
+                slot.canceled = true;
+                ++slot.generation;
             }
         }
 
-        m_Jobs.clear();
+        // Returning the slabs of the destroyed jobs to the heap
+        // NOTE(yuval): Slabs that still hold running jobs are released by a later Clear.
+        m_JobPool.Trim();
     }
 
     void Runner::CancelJob(Job* job)
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-
-        JOB_MAP_ITER iter = std::find_if(m_Jobs.begin(), m_Jobs.end(),
-                                         [job](const std::pair<std::time_t, Job*>& element)
-        {
-            return job == element.second;
-        });
+        std::lock_guard<TimedMutex> lock(m_Mutex);
 
-        // If no job was found there is no job for us to cancel
-        if (iter == m_Jobs.end())
+        // If the job isn't bound to this runner there is no job for us to cancel
+        if (job == nullptr || job->m_Handle.GetRunner() != this || job->m_Handle.Empty() ||
+            m_Slots[job->m_Handle.Index()].job != job || m_Slots[job->m_Handle.Index()].canceled)
         {
             return;
         }
 
-        Job* jobToRemove = iter->second;
+        CancelSlot(job->m_Handle.Index());
+    }
+
+    bool Runner::CancelJob(const JobHandle& handle)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
 
-        // Deleting the job object
-        if (jobToRemove != nullptr)
+        if (FindSlot(handle) == nullptr)
         {
-            delete jobToRemove;
+            return false;
         }
 
-        // Removing the job pointer from the job map
-        m_Jobs.erase(iter);
+        CancelSlot(handle.Index());
+        return true;
+    }
+
+    Job* Runner::GetJob(const JobHandle& handle)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        JobSlot* slot = FindSlot(handle);
+
+        return slot == nullptr ? nullptr : slot->job;
     }
 
     Job* Runner::FindJob(const JOB_FUNC_TYPE& fn)
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        DrainInbox();
 
-        JOB_MAP_ITER iter = std::find_if(m_Jobs.begin(), m_Jobs.end(),
-                                         [fn](const std::pair<std::time_t, Job*>& element)
+        return m_Jobs->Find([&fn](Job* currJob)
         {
-            Job* currJob = element.second;
-            return currJob != nullptr && GET_FN_ADDR(fn) == GET_FN_ADDR(currJob->JobFunc());
+            return currJob != nullptr && fn.SameTarget(currJob->JobFunc());
         });
+    }
+
+    Job* Runner::FindJob(const std::string& name)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        auto entry = m_Names.find(name);
+
+        if (entry == m_Names.end())
+        {
+            return nullptr;
+        }
+
+        JobSlot* slot = FindSlot(entry->second);
+        return slot == nullptr ? nullptr : slot->job;
+    }
+
+    std::vector<JobHandle> Runner::FindByTag(const std::string& tag)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        std::vector<JobHandle> handles;
+        auto entry = m_Tags.find(tag);
+
+        if (entry == m_Tags.end())
+        {
+            return handles;
+        }
+
+        for (const JobHandle& handle : entry->second.handles)
+        {
+            if (FindSlot(handle) != nullptr)
+            {
+                handles.push_back(handle);
+            }
+        }
+
+        return handles;
+    }
+
+    std::size_t Runner::CancelByTag(const std::string& tag)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        auto entry = m_Tags.find(tag);
+
+        if (entry == m_Tags.end())
+        {
+            return 0;
+        }
+
+        // NOTE(yuval): Canceling a job might destroy it, which updates the tag's entry, so the handles are moved out
+        std::vector<JobHandle> handles = std::move(entry->second.handles);
+        entry->second.handles.clear();
+        std::size_t canceled = 0;
+
+        for (const JobHandle& handle : handles)
+        {
+            if (FindSlot(handle) != nullptr)
+            {
+                CancelSlot(handle.Index());
+                ++canceled;
+            }
+        }
 
-        return iter == m_Jobs.end() ? nullptr : iter->second;
+        return canceled;
     }
 
     Job& Runner::Every(int interval)
     {
-        return *(new Job(interval, this));
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        void* storage = m_JobPool.Allocate();
+        Job* job;
+
+        try
+        {
+            job = new (storage) Job(interval, this);
+        }
+        catch (...)
+        {
+            m_JobPool.Free(storage);
+            throw;
+        }
+
+        job->m_Pooled = true;
+        return *job;
     }
 
     std::string Runner::NextRun()
@@ -188,38 +632,855 @@ namespace Jobs
 
     int Runner::IdleSeconds()
     {
-        tm* nextRunTime = NextRunningJobTime();
+        JOB_TIME_TYPE nextRunTime;
 
-        if (nextRunTime == nullptr)
+        if (!NextRunningJobTime(nextRunTime))
         {
             return -1;
         }
 
-        return static_cast<int>(std::difftime(std::mktime(nextRunTime), std::time(nullptr)));
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(
+            nextRunTime - m_Clock->Now()).count());
     }
 
-    void Runner::RunJob(Job* job)
+    bool Runner::SaveSchedule(const std::string& path)
     {
-        // Running the job in the thread pool, and then adding it back to the job map
-        m_Threads.push([this, job](int)
+        std::vector<ScheduleRecord> records;
+
         {
-            job->Run();
+            std::lock_guard<TimedMutex> lock(m_Mutex);
+            DrainInbox();
 
-            // NOTE(yuval): AddJob will wait for the Run function to release the mutex!
-            AddJob(job->GetNextRun(), job);
-        });
+            // NOTE(yuval): Running jobs are saved with the run time of their current run
+            SnapshotTimeBase base(*m_Clock);
+
+            for (const JobSlot& slot : m_Slots)
+            {
+                if (slot.job == nullptr || slot.canceled || slot.job->GetId() == 0)
+                {
+                    continue;
+                }
+
+                records.emplace_back();
+                slot.job->ToRecord(records.back(), base);
+            }
+        }
+
+        return ScheduleSnapshot::Write(path, records);
     }
 
-    std::tm* Runner::NextRunningJobTime()
+    std::size_t Runner::RestoreSchedule(const std::string& path, CatchUpPolicy::Policy catchUp)
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        m_SnapshotRecords.clear();
 
-        if (m_Jobs.empty())
+        if (!m_Snapshot.Open(path))
         {
-            return nullptr;
+            return 0;
+        }
+
+        // Indexing the records by id, so every job that is added finds its record in constant time
+        const ScheduleRecord* records = m_Snapshot.Records();
+        m_SnapshotRecords.reserve(m_Snapshot.Size());
+
+        for (std::size_t i = 0; i < m_Snapshot.Size(); ++i)
+        {
+            m_SnapshotRecords[records[i].id] = &records[i];
         }
 
-        return localtime(&m_Jobs.begin()->first);
+        m_SnapshotTimeBase = SnapshotTimeBase(*m_Clock);
+        m_CatchUp = catchUp;
+
+        return m_SnapshotRecords.size();
+    }
+
+    RunnerMetrics Runner::Metrics()
+    {
+        RunnerMetrics metrics;
+        metrics.time = std::chrono::steady_clock::now();
+
+        {
+            std::lock_guard<TimedMutex> lock(m_Mutex);
+            metrics.storedJobs = m_Jobs->Size();
+            metrics.throttledJobs = m_Backlog.size() - m_BacklogHead;
+        }
+
+        // The lanes' executors are counted together with the runner's executor
+        unsigned int workerCount = 0;
+        metrics.queuedTasks = 0;
+        metrics.busyWorkers = 0;
+
+        ForEachExecutor([&](const std::shared_ptr<Executor>& executor, long)
+        {
+            workerCount += executor->WorkerCount();
+            metrics.queuedTasks += executor->QueuedTaskCount();
+            metrics.busyWorkers += executor->BusyWorkerCount();
+        });
+
+        metrics.idleWorkers = workerCount > metrics.busyWorkers ? workerCount - metrics.busyWorkers : 0;
+
+        metrics.jobsFired = m_JobsFired.Load();
+        metrics.sleeperWakeups = m_SleeperWakeups.Load();
+        metrics.spuriousWakeups = m_SpuriousWakeups.Load();
+        metrics.runsSkipped = m_RunsSkipped.Load();
+        metrics.runsCoalesced = m_RunsCoalesced.Load();
+        metrics.runsQueued = m_RunsQueued.Load();
+        m_Mutex.Snapshot(metrics);
+
+        // Computing the fire rate since the previous snapshot
+        {
+            std::lock_guard<std::mutex> lock(m_MetricsMutex);
+            std::chrono::duration<double> elapsed = metrics.time - m_LastMetricsTime;
+
+            metrics.jobsFiredPerSecond = m_LastMetricsTime == JOB_TIME_TYPE() || elapsed.count() <= 0.0 ? 0.0 :
+                static_cast<double>(metrics.jobsFired - m_LastJobsFired) / elapsed.count();
+
+            m_LastMetricsTime = metrics.time;
+            m_LastJobsFired = metrics.jobsFired;
+        }
+
+        return metrics;
+    }
+
+    void Runner::WriteMetrics(std::ostream& out)
+    {
+        WritePrometheusText(out, Metrics());
+    }
+
+    void Runner::ExportMetrics(const std::string& path, std::chrono::milliseconds period)
+    {
+        StopExportingMetrics();
+        m_MetricsExporter.reset(new MetricsExporter([this, path]
+        {
+            WritePrometheusFile(path, Metrics());
+        }, period));
+    }
+
+    void Runner::ExportMetrics(std::ostream& out, std::chrono::milliseconds period)
+    {
+        StopExportingMetrics();
+        m_MetricsExporter.reset(new MetricsExporter([this, &out]
+        {
+            WriteMetrics(out);
+            out.flush();
+        }, period));
+    }
+
+    void Runner::StopExportingMetrics()
+    {
+        m_MetricsExporter.reset();
+    }
+
+    std::size_t Runner::RunExpired(bool all)
+    {
+        std::lock_guard<std::mutex> runLock(m_RunMutex);
+        JOB_TIME_TYPE now = m_Clock->Now();
+        std::size_t drained;
+        std::size_t realtimeJobs = 0;
+
+        {
+            std::lock_guard<TimedMutex> lock(m_Mutex);
+            drained = DrainInbox();
+
+            // Removing the pending jobs from the job store
+            m_JobsToRun.clear();
+
+            if (all)
+            {
+                m_Jobs->PopAll(m_JobsToRun);
+            }
+            else
+            {
+                m_Jobs->PopExpired(now, m_JobsToRun);
+            }
+
+            if (m_ThrottleJobs != 0 || m_BacklogHead != m_Backlog.size())
+            {
+                ThrottleJobsToRun(now);
+            }
+
+            // NOTE(yuval): A job that isn't dispatched now is replaced with nullptr
+            for (Job*& job : m_JobsToRun)
+            {
+                if (job->m_Ext != nullptr && job->Graph() != nullptr)
+                {
+                    if (!AdmitIteration(job, now))
+                    {
+                        job = nullptr;
+                    }
+                }
+                else if (job->m_Ext != nullptr && job->HasOverlapPolicy())
+                {
+                    if (!AdmitOverlapping(job, now))
+                    {
+                        job = nullptr;
+                    }
+                }
+                else
+                {
+                    job->Dispatched(now);
+                    m_Slots[job->m_Handle.Index()].state = SlotRunning;
+                }
+
+                if (job != nullptr && job->m_Priority == JobPriority::Realtime)
+                {
+                    ++realtimeJobs;
+                }
+            }
+
+            // Removing the expired timers
+            m_TimersToRun.clear();
+
+            while (!m_Timers.empty() && m_Timers.front().time <= now)
+            {
+                m_TimersToRun.push_back(m_Timers.front());
+                std::pop_heap(m_Timers.begin(), m_Timers.end(), TimerLater);
+                m_Timers.pop_back();
+            }
+        }
+
+        // Running all the panding jobs
+        // NOTE(yuval): The jobs are dispatched without holding m_Mutex, so jobs that run inline can call
+        //              the runner. A running job is only destroyed after it pushed itself back to the inbox,
+        //              and the jobs that are re-added are stored by the next drain, after they were removed.
+        std::size_t firedJobs = 0;
+
+        // The realtime jobs are dispatched first, so they don't wait for a batch of other jobs to be dispatched
+        if (realtimeJobs != 0)
+        {
+            for (Job* job : m_JobsToRun)
+            {
+                if (job != nullptr && job->m_Priority == JobPriority::Realtime)
+                {
+                    RunJob(job);
+                    ++firedJobs;
+                }
+            }
+        }
+
+        for (Job* job : m_JobsToRun)
+        {
+            if (job != nullptr && (realtimeJobs == 0 || job->m_Priority != JobPriority::Realtime))
+            {
+                RunJob(job);
+                ++firedJobs;
+            }
+        }
+
+        if (firedJobs != 0)
+        {
+            m_JobsFired.Add(firedJobs);
+        }
+
+        for (const Timer& timer : m_TimersToRun)
+        {
+            m_LaneExecutors[timer.priority]->Submit(timer.task);
+        }
+
+        return drained + m_JobsToRun.size() + m_TimersToRun.size();
+    }
+
+    void Runner::ThrottleJobsToRun(JOB_TIME_TYPE now)
+    {
+        // NOTE(yuval): The jobs in the backlog are out of the job store, so they count as running
+        //              and a job that is canceled while it waits is destroyed when it is taken back.
+        for (Job* job : m_JobsToRun)
+        {
+            m_Slots[job->m_Handle.Index()].state = SlotRunning;
+            m_Backlog.push_back(job);
+        }
+
+        m_JobsToRun.clear();
+
+        // Starting a new tick, the backlog of a runner that stopped throttling is dispatched at once
+        if (m_ThrottleJobs == 0)
+        {
+            m_TickBudget = std::numeric_limits<std::size_t>::max();
+        }
+        else if (now >= m_TickStart + m_ThrottleTick)
+        {
+            m_TickStart = now;
+            m_TickBudget = m_ThrottleJobs;
+        }
+
+        while (m_TickBudget != 0 && m_BacklogHead != m_Backlog.size())
+        {
+            Job* job = m_Backlog[m_BacklogHead++];
+
+            if (m_Slots[job->m_Handle.Index()].canceled)
+            {
+                DestroyStoredJob(job);
+                continue;
+            }
+
+            m_JobsToRun.push_back(job);
+            --m_TickBudget;
+        }
+
+        // Dropping the dispatched prefix once it outgrows the jobs that still wait
+        if (m_BacklogHead == m_Backlog.size())
+        {
+            m_Backlog.clear();
+            m_BacklogHead = 0;
+        }
+        else if (m_BacklogHead > m_Backlog.size() / 2)
+        {
+            m_Backlog.erase(m_Backlog.begin(), m_Backlog.begin() + static_cast<std::ptrdiff_t>(m_BacklogHead));
+            m_BacklogHead = 0;
+        }
+    }
+
+    bool Runner::AdmitOverlapping(Job* job, JOB_TIME_TYPE now)
+    {
+        Job::RunAdmission admission = job->Admit();
+
+        // NOTE(yuval): The dispatch is recorded before the job is rescheduled, while it still holds the run time
+        if (admission == Job::AdmitRun)
+        {
+            job->Dispatched(now);
+        }
+
+        // Rescheduling the job right away, so it keeps its schedule while it runs
+        job->m_NextRun = job->GetNextRun(now);
+        m_Jobs->Insert(job->m_NextRun, job);
+        m_Slots[job->m_Handle.Index()].state = SlotScheduled;
+
+        switch (admission)
+        {
+        case Job::AdmitRun:
+            return true;
+
+        case Job::AdmitQueued:
+            m_RunsQueued.Add();
+            break;
+
+        case Job::AdmitCoalesced:
+            m_RunsCoalesced.Add();
+            break;
+
+        case Job::AdmitSkipped:
+            m_RunsSkipped.Add();
+            break;
+        }
+
+        return false;
+    }
+
+    bool Runner::AdmitIteration(Job* job, JOB_TIME_TYPE now)
+    {
+        if (job->Graph()->BeginIteration())
+        {
+            job->Dispatched(now);
+            m_Slots[job->m_Handle.Index()].state = SlotRunning;
+            return true;
+        }
+
+        // The graph has as many iterations in flight as it allows, so the root skips this run
+        job->m_NextRun = job->GetNextRun(now);
+        m_Jobs->Insert(job->m_NextRun, job);
+        m_Slots[job->m_Handle.Index()].state = SlotScheduled;
+        m_RunsSkipped.Add();
+
+        return false;
+    }
+
+    bool Runner::RestoreRun(Job* job, JOB_TIME_TYPE& time)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        return RestoreRunLocked(job, time);
+    }
+
+    bool Runner::RestoreRunLocked(Job* job, JOB_TIME_TYPE& time)
+    {
+        if (m_SnapshotRecords.empty())
+        {
+            return false;
+        }
+
+        auto record = m_SnapshotRecords.find(job->GetId());
+
+        if (record == m_SnapshotRecords.end())
+        {
+            return false;
+        }
+
+        // A job whose schedule changed since the snapshot was taken starts over
+        bool restored = job->MatchesRecord(*record->second);
+
+        if (restored)
+        {
+            time = job->Restore(*record->second, m_SnapshotTimeBase, m_CatchUp, m_Clock->Now());
+        }
+
+        m_SnapshotRecords.erase(record);
+
+        if (m_SnapshotRecords.empty())
+        {
+            m_Snapshot.Close();
+        }
+
+        return restored;
+    }
+
+    void Runner::AllocateJobs(std::size_t count, std::vector<void*>& storage)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            storage.push_back(m_JobPool.Allocate());
+        }
+    }
+
+    void Runner::FreeJobs(const std::vector<void*>& storage)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+
+        for (void* item : storage)
+        {
+            m_JobPool.Free(item);
+        }
+    }
+
+    void Runner::RunJob(Job* job)
+    {
+        // Running the job on the executor, the job pushes itself back to the inbox once it completes
+        // NOTE(yuval): A job with an overlap policy stays in the job store, so it may be dispatched again
+        //              while it runs, and it is only pushed back to the inbox once it was canceled.
+        m_LaneExecutors[job->m_Priority]->Submit(job);
+    }
+
+    template <typename F>
+    void Runner::ForEachExecutor(F&& fn)
+    {
+        fn(m_Executor, 1);
+
+        // A lane that serves several classes is visited once, with the number of references the runner holds
+        for (std::size_t i = 0; i < m_Lanes.size(); ++i)
+        {
+            if (m_Lanes[i] == nullptr || std::find(m_Lanes.begin(), m_Lanes.begin() + i, m_Lanes[i]) != m_Lanes.begin() + i)
+            {
+                continue;
+            }
+
+            fn(m_Lanes[i], static_cast<long>(std::count(m_Lanes.begin(), m_Lanes.end(), m_Lanes[i])));
+        }
+    }
+
+    JobHandle Runner::AcquireSlot(Job* job)
+    {
+        std::uint32_t index;
+
+        if (m_FreeSlots != NO_SLOT)
+        {
+            index = m_FreeSlots;
+            m_FreeSlots = m_Slots[index].nextFree;
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(m_Slots.size());
+            m_Slots.push_back(JobSlot{ nullptr, 1, NO_SLOT, SlotFree, false });
+        }
+
+        JobSlot& slot = m_Slots[index];
+        slot.job = job;
+        slot.nextFree = NO_SLOT;
+        slot.state = SlotScheduled;
+        slot.canceled = false;
+
+        // Generation 0 marks the handles of unregistered jobs, so a wrapped around generation skips it
+        if (slot.generation == 0)
+        {
+            slot.generation = 1;
+        }
+
+        JobHandle handle(this, index, slot.generation);
+
+        if (job->m_Ext != nullptr)
+        {
+            IndexJob(job, handle);
+        }
+
+        return handle;
+    }
+
+    void Runner::IndexJob(Job* job, const JobHandle& handle)
+    {
+        if (!job->GetName().empty())
+        {
+            m_Names[job->GetName()] = handle;
+        }
+
+        for (const std::string& tag : job->GetTags())
+        {
+            TagIndex& index = m_Tags[tag];
+            ++index.jobCount;
+
+            // Dropping the stale entries once they outnumber the tag's jobs
+            if (index.handles.size() >= 2 * index.jobCount)
+            {
+                index.handles.erase(std::remove_if(index.handles.begin(), index.handles.end(),
+                    [this](const JobHandle& entry)
+                    {
+                        return FindSlot(entry) == nullptr;
+                    }), index.handles.end());
+            }
+
+            index.handles.push_back(handle);
+        }
+    }
+
+    void Runner::UnindexJob(Job* job)
+    {
+        std::uint32_t slot = job->m_Handle.Index();
+
+        if (!job->GetName().empty())
+        {
+            auto entry = m_Names.find(job->GetName());
+
+            // A job that took over the name from this one keeps it
+            if (entry != m_Names.end() && entry->second.Index() == slot)
+            {
+                m_Names.erase(entry);
+            }
+        }
+
+        for (const std::string& tag : job->GetTags())
+        {
+            auto entry = m_Tags.find(tag);
+
+            if (entry != m_Tags.end() && --entry->second.jobCount == 0)
+            {
+                m_Tags.erase(entry);
+            }
+        }
+    }
+
+    Runner::JobSlot* Runner::FindSlot(const JobHandle& handle)
+    {
+        if (handle.GetRunner() != this || handle.Empty() || handle.Index() >= m_Slots.size())
+        {
+            return nullptr;
+        }
+
+        JobSlot& slot = m_Slots[handle.Index()];
+
+        if (slot.job == nullptr || slot.canceled || slot.generation != handle.Generation())
+        {
+            return nullptr;
+        }
+
+        return &slot;
+    }
+
+    void Runner::CancelSlot(std::uint32_t index)
+    {
+        JobSlot& slot = m_Slots[index];
+
+        // Invalidating all the handles to the job
+        ++slot.generation;
+
+        if (slot.state == SlotScheduled)
+        {
+            m_Jobs->Remove(slot.job);
+
+            if (!DestroyStoredJob(slot.job))
+            {
+                slot.state = SlotRunning;
+                slot.canceled = true;
+            }
+        }
+        else
+        {
+            slot.canceled = true;
+        }
+    }
+
+    void Runner::DestroyJob(Job* job)
+    {
+        std::uint32_t index = job->m_Handle.Index();
+        JobSlot& slot = m_Slots[index];
+
+        if (job->m_Ext != nullptr)
+        {
+            UnindexJob(job);
+        }
+
+        slot.job = nullptr;
+        slot.state = SlotFree;
+        slot.canceled = false;
+        ++slot.generation;
+
+        // Pushing the slot to the free list
+        slot.nextFree = m_FreeSlots;
+        m_FreeSlots = index;
+
+        FreeJob(job);
+    }
+
+    bool Runner::DestroyStoredJob(Job* job)
+    {
+        if (job->m_Ext != nullptr && job->HasOverlapPolicy() && !job->RetireOverlapping())
+        {
+            return false;
+        }
+
+        if (job->m_Ext != nullptr && job->Graph() != nullptr)
+        {
+            JobGraph* graph = job->Graph();
+
+            if (!graph->RetireRoot(job))
+            {
+                return false;
+            }
+
+            // NOTE(yuval): The jobs that run after other jobs have no slot, they go with the graph's last root
+            //              (which keeps the graph alive while they are destroyed).
+            if (graph->Retired())
+            {
+                std::vector<Job*> downstreamJobs;
+                graph->DownstreamJobs(downstreamJobs);
+
+                for (Job* downstreamJob : downstreamJobs)
+                {
+                    FreeJob(downstreamJob);
+                }
+            }
+        }
+
+        DestroyJob(job);
+        return true;
+    }
+
+    void Runner::FreeJob(Job* job)
+    {
+        if (job->m_Pooled)
+        {
+            job->~Job();
+            m_JobPool.Free(job);
+        }
+        else
+        {
+            delete job;
+        }
+    }
+
+    void Runner::PushInbox(JOB_TIME_TYPE time, Job* job)
+    {
+        // Pushing the job to the head of the inbox (a Treiber stack, any thread may push)
+        job->m_NextRun = time;
+        Job* head = m_Inbox.load(std::memory_order_relaxed);
+
+        do
+        {
+            job->m_InboxNext = head;
+        } while (!m_Inbox.compare_exchange_weak(head, job));
+
+        // NOTE(yuval): The push and the deadline load are both sequentially consistent, and so are the
+        //              timer thread's deadline store and inbox load, so either the timer thread sees
+        //              the job before it sleeps or we see the deadline it is going to sleep until.
+        //              The job must not be touched after the push, so the time is compared instead.
+        if (time.time_since_epoch().count() < m_WakeupDeadline.load())
+        {
+            m_Sleeper.Interrupt();
+        }
+    }
+
+    std::size_t Runner::DrainInbox()
+    {
+        // Taking the whole inbox at once, so a burst of completions is stored in one batch
+        Job* job = m_Inbox.exchange(nullptr);
+        std::size_t drained = 0;
+
+        while (job != nullptr)
+        {
+            Job* next = job->m_InboxNext;
+            job->m_InboxNext = nullptr;
+
+            JobSlot& slot = m_Slots[job->m_Handle.Index()];
+
+            // A job that was canceled while it was running is destroyed instead of being re-added
+            // NOTE(yuval): A graph's root waits for the iterations it started, the last of which pushes it again.
+            if (slot.canceled)
+            {
+                DestroyStoredJob(job);
+            }
+            else
+            {
+                slot.state = SlotScheduled;
+                m_Jobs->Insert(job->m_NextRun, job);
+            }
+
+            job = next;
+            ++drained;
+        }
+
+        return drained;
+    }
+
+    void Runner::RunLoop()
+    {
+        bool wokeUp = false;
+
+        while (m_IsRunning)
+        {
+            JOB_TIME_TYPE wakeupTime;
+            bool hasJobs = Step(wakeupTime, wokeUp);
+            wokeUp = false;
+
+            // Jobs that were pushed before the deadline was published are drained before sleeping
+            if (m_Inbox.load() != nullptr)
+            {
+                continue;
+            }
+
+            if (!hasJobs)
+            {
+                m_Sleeper.Sleep();
+            }
+            else
+            {
+                m_Sleeper.SleepUntil(wakeupTime);
+            }
+
+            wokeUp = true;
+        }
+    }
+
+    bool Runner::Step(JOB_TIME_TYPE& wakeupTime, bool wokeUp)
+    {
+        // Jobs that are pushed while the runner is awake don't interrupt the sleeper
+        m_WakeupDeadline = AWAKE;
+        std::size_t handledJobs = RunExpired();
+        bool hasJobs;
+
+        {
+            std::lock_guard<TimedMutex> lock(m_Mutex);
+            handledJobs += DrainInbox();
+            hasJobs = NextWakeupTimeLocked(wakeupTime);
+
+            // NOTE(yuval): The deadline is published while holding m_Mutex, for SubmitAt
+            m_WakeupDeadline = hasJobs ? wakeupTime.time_since_epoch().count() :
+                                         std::numeric_limits<JOB_CLOCK_TYPE::rep>::max();
+        }
+
+        // A wakeup that had nothing to do was spurious
+        if (wokeUp)
+        {
+            m_SleeperWakeups.Add();
+
+            if (handledJobs == 0)
+            {
+                m_SpuriousWakeups.Add();
+            }
+        }
+
+        return hasJobs;
+    }
+
+    int Runner::GetPollFd()
+    {
+        if (m_IsRunning)
+        {
+            throw JobException("The Runner Runs A Timer Thread Of Its Own");
+        }
+
+        int pollFd = m_Sleeper.GetPollFd();
+
+        if (pollFd == -1)
+        {
+            throw JobException("The Runner Has No Poll Fd");
+        }
+
+        // NOTE(yuval): The fd starts out readable, so the event loop's first ProcessReady arms it
+        if (!m_IsEmbedded.exchange(true))
+        {
+            m_Sleeper.Interrupt();
+        }
+
+        return pollFd;
+    }
+
+    void Runner::ProcessReady()
+    {
+        // NOTE(yuval): The readiness is cleared before the jobs are handled, so an interrupt that comes
+        //              meanwhile leaves the fd readable for the event loop's next round.
+        bool wokeUp = m_Sleeper.Consume();
+        JOB_TIME_TYPE wakeupTime;
+        bool hasJobs;
+
+        // Jobs that were pushed before the deadline was published are drained before the fd is armed
+        do
+        {
+            hasJobs = Step(wakeupTime, wokeUp);
+            wokeUp = false;
+        } while (m_Inbox.load() != nullptr);
+
+        if (hasJobs)
+        {
+            m_Sleeper.Arm(wakeupTime);
+        }
+        else
+        {
+            m_Sleeper.Disarm();
+        }
+    }
+
+    std::tm* Runner::NextRunningJobTime()
+    {
+        JOB_TIME_TYPE nextRunTime;
+
+        if (!NextRunningJobTime(nextRunTime))
+        {
+            return nullptr;
+        }
+
+        std::time_t nextRunWallTime = m_Clock->ToTimeT(nextRunTime);
+        return localtime(&nextRunWallTime);
+    }
+
+    bool Runner::NextRunningJobTime(JOB_TIME_TYPE& time)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        DrainInbox();
+        return m_Jobs->NextRunTime(time);
+    }
+
+    bool Runner::NextWakeupTime(JOB_TIME_TYPE& time)
+    {
+        std::lock_guard<TimedMutex> lock(m_Mutex);
+        DrainInbox();
+        return NextWakeupTimeLocked(time);
+    }
+
+    bool Runner::NextWakeupTimeLocked(JOB_TIME_TYPE& time)
+    {
+        bool hasJobs = m_Jobs->NextRunTime(time);
+
+        // Jobs that wait for the dispatch throttle run at the next tick
+        if (m_BacklogHead != m_Backlog.size())
+        {
+            JOB_TIME_TYPE nextTick = m_TickStart + m_ThrottleTick;
+
+            if (!hasJobs || nextTick < time)
+            {
+                time = nextTick;
+                hasJobs = true;
+            }
+        }
+
+        if (!m_Timers.empty() && (!hasJobs || m_Timers.front().time < time))
+        {
+            time = m_Timers.front().time;
+            return true;
+        }
+
+        return hasJobs;
+    }
+
+    bool Runner::TimerLater(const Timer& lhs, const Timer& rhs)
+    {
+        return lhs.time > rhs.time;
     }
 }
 
@@ -0,0 +1,182 @@
+#include "Jobs/RunnerMetrics.h"
+#include <cstdio>
+#include <fstream>
+
+namespace Jobs
+{
+    namespace
+    {
+        // Writes a single metric with its help and type lines
+        template <typename T>
+        void WriteMetric(std::ostream& out, const char* name, const char* type, const char* help, T value)
+        {
+            out << "# HELP " << name << ' ' << help << '\n';
+            out << "# TYPE " << name << ' ' << type << '\n';
+            out << name << ' ' << value << '\n';
+        }
+
+        inline double ToSeconds(std::chrono::nanoseconds duration)
+        {
+            return std::chrono::duration<double>(duration).count();
+        }
+    }
+
+    void RunnerMetrics::AddRunner(const RunnerMetrics& other)
+    {
+        storedJobs += other.storedJobs;
+        throttledJobs += other.throttledJobs;
+        jobsFired += other.jobsFired;
+        jobsFiredPerSecond += other.jobsFiredPerSecond;
+        runsSkipped += other.runsSkipped;
+        runsCoalesced += other.runsCoalesced;
+        runsQueued += other.runsQueued;
+        sleeperWakeups += other.sleeperWakeups;
+        spuriousWakeups += other.spuriousWakeups;
+        mutexAcquisitions += other.mutexAcquisitions;
+        mutexContentions += other.mutexContentions;
+        mutexWaitTime += other.mutexWaitTime;
+        mutexHoldTime += other.mutexHoldTime;
+    }
+
+    void WritePrometheusText(std::ostream& out, const RunnerMetrics& metrics)
+    {
+        WriteMetric(out, "jobs_stored_jobs", "gauge", "Jobs in the job store.", metrics.storedJobs);
+        WriteMetric(out, "jobs_throttled_jobs", "gauge", "Due jobs that wait for the dispatch throttle.",
+                    metrics.throttledJobs);
+        WriteMetric(out, "jobs_executor_queued_tasks", "gauge",
+                    "Tasks that were submitted to the executor but didn't start yet.", metrics.queuedTasks);
+        WriteMetric(out, "jobs_executor_busy_workers", "gauge", "Executor workers that are running a task.",
+                    metrics.busyWorkers);
+        WriteMetric(out, "jobs_executor_idle_workers", "gauge", "Executor workers that aren't running a task.",
+                    metrics.idleWorkers);
+        WriteMetric(out, "jobs_fired_total", "counter", "Jobs that were handed to the executor.",
+                    metrics.jobsFired);
+        WriteMetric(out, "jobs_fired_per_second", "gauge",
+                    "Jobs that were handed to the executor per second, since the previous export.",
+                    metrics.jobsFiredPerSecond);
+        WriteMetric(out, "jobs_runs_skipped_total", "counter",
+                    "Runs that were dropped since their job was still running.", metrics.runsSkipped);
+        WriteMetric(out, "jobs_runs_coalesced_total", "counter",
+                    "Runs that were merged into the pending run of a job that was still running.", metrics.runsCoalesced);
+        WriteMetric(out, "jobs_runs_queued_total", "counter",
+                    "Runs that waited for the previous run of their job to complete.", metrics.runsQueued);
+        WriteMetric(out, "jobs_sleeper_wakeups_total", "counter", "Times the timer thread woke up.",
+                    metrics.sleeperWakeups);
+        WriteMetric(out, "jobs_sleeper_spurious_wakeups_total", "counter",
+                    "Timer thread wakeups that found no job to run and no job to store.", metrics.spuriousWakeups);
+        WriteMetric(out, "jobs_mutex_acquisitions_total", "counter", "Acquisitions of the runner's mutex.",
+                    metrics.mutexAcquisitions);
+        WriteMetric(out, "jobs_mutex_contentions_total", "counter",
+                    "Acquisitions of the runner's mutex that had to wait for another thread.",
+                    metrics.mutexContentions);
+        WriteMetric(out, "jobs_mutex_wait_seconds_total", "counter", "Time spent waiting for the runner's mutex.",
+                    ToSeconds(metrics.mutexWaitTime));
+        WriteMetric(out, "jobs_mutex_hold_seconds_total", "counter", "Time the runner's mutex was held.",
+                    ToSeconds(metrics.mutexHoldTime));
+    }
+
+    bool WritePrometheusFile(const std::string& path, const RunnerMetrics& metrics)
+    {
+        // Writing a temporary file and renaming it over the old one
+        std::string tempPath = path + ".tmp";
+
+        {
+            std::ofstream out(tempPath, std::ios::trunc);
+
+            if (!out)
+            {
+                return false;
+            }
+
+            WritePrometheusText(out, metrics);
+
+            if (!out.flush())
+            {
+                return false;
+            }
+        }
+
+        return std::rename(tempPath.c_str(), path.c_str()) == 0;
+    }
+
+    void TimedMutex::lock()
+    {
+        Clock::time_point acquireTime;
+
+        if (m_Mutex.try_lock())
+        {
+            acquireTime = Clock::now();
+        }
+        else
+        {
+            // Only contended acquisitions pay for measuring the wait
+            Clock::time_point waitStart = Clock::now();
+            m_Mutex.lock();
+            acquireTime = Clock::now();
+
+            m_Contentions.Add();
+            m_WaitTime.Add(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(acquireTime - waitStart).count()));
+        }
+
+        m_AcquireTime = acquireTime;
+        m_Acquisitions.Add();
+    }
+
+    bool TimedMutex::try_lock()
+    {
+        if (!m_Mutex.try_lock())
+        {
+            return false;
+        }
+
+        m_AcquireTime = Clock::now();
+        m_Acquisitions.Add();
+
+        return true;
+    }
+
+    void TimedMutex::unlock()
+    {
+        // NOTE(yuval): The acquire time has to be read before the mutex is released
+        Clock::duration holdTime = Clock::now() - m_AcquireTime;
+        m_Mutex.unlock();
+
+        m_HoldTime.Add(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(holdTime).count()));
+    }
+
+    void TimedMutex::Snapshot(RunnerMetrics& metrics) const
+    {
+        metrics.mutexAcquisitions = m_Acquisitions.Load();
+        metrics.mutexContentions = m_Contentions.Load();
+        metrics.mutexWaitTime = std::chrono::nanoseconds(m_WaitTime.Load());
+        metrics.mutexHoldTime = std::chrono::nanoseconds(m_HoldTime.Load());
+    }
+
+    MetricsExporter::MetricsExporter(std::function<void()> exportFunc, std::chrono::milliseconds period)
+        : m_ExportFunc(std::move(exportFunc)), m_Period(period), m_IsRunning(true)
+    {
+        m_Thread = std::thread(&MetricsExporter::RunLoop, this);
+    }
+
+    MetricsExporter::~MetricsExporter()
+    {
+        m_IsRunning = false;
+        m_Sleeper.Interrupt();
+
+        if (m_Thread.joinable())
+        {
+            m_Thread.join();
+        }
+    }
+
+    void MetricsExporter::RunLoop()
+    {
+        while (m_IsRunning)
+        {
+            m_ExportFunc();
+            m_Sleeper.SleepFor(m_Period);
+        }
+    }
+}
@@ -0,0 +1,244 @@
+#include "Jobs/ScheduleSnapshot.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <memory>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Jobs
+{
+    namespace
+    {
+        struct SnapshotHeader
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t recordSize;
+            std::uint64_t count;
+            std::uint64_t reserved;
+        };
+
+        constexpr char SNAPSHOT_MAGIC[8] = { 'J', 'O', 'B', 'S', 'N', 'A', 'P', '1' };
+        constexpr std::uint32_t SNAPSHOT_VERSION = 1;
+
+        // NOTE(yuval): The records are read in place, so the layout is part of the file format
+        static_assert(sizeof(SnapshotHeader) == 32, "The snapshot header layout changed");
+        static_assert(sizeof(ScheduleRecord) == 40, "The schedule record layout changed");
+
+#ifndef _WIN32
+        // Writes the whole buffer, resuming after partial writes and interrupts
+        bool WriteAll(int fd, const void* data, std::size_t size)
+        {
+            const char* bytes = static_cast<const char*>(data);
+
+            while (size > 0)
+            {
+                ssize_t written = ::write(fd, bytes, size);
+
+                if (written == -1)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    return false;
+                }
+
+                bytes += written;
+                size -= static_cast<std::size_t>(written);
+            }
+
+            return true;
+        }
+
+        // Flushes the directory that holds the given path, so a rename into it survives a power loss
+        bool SyncParentDirectory(const std::string& path)
+        {
+            std::size_t slash = path.rfind('/');
+            std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+
+            int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+            if (fd == -1)
+            {
+                return false;
+            }
+
+            bool synced = ::fsync(fd) == 0;
+            ::close(fd);
+            return synced;
+        }
+#endif
+    }
+
+    ScheduleSnapshot::ScheduleSnapshot()
+        : m_Data(nullptr), m_Length(0), m_Records(nullptr), m_Count(0)
+    {
+    }
+
+    ScheduleSnapshot::~ScheduleSnapshot()
+    {
+        Close();
+    }
+
+    bool ScheduleSnapshot::Write(const std::string& path, const std::vector<ScheduleRecord>& records)
+    {
+        SnapshotHeader header;
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.recordSize = sizeof(ScheduleRecord);
+        header.count = records.size();
+        header.reserved = 0;
+
+        // Writing a temporary file and renaming it over the old one, so a crash never leaves a torn snapshot
+        std::string tempPath = path + ".tmp";
+
+#ifdef _WIN32
+        // NOTE(yuval): The file isn't flushed to the disk here, so this only covers a crash of the process
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+
+            if (!out)
+            {
+                return false;
+            }
+
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(records.data()),
+                      static_cast<std::streamsize>(records.size() * sizeof(ScheduleRecord)));
+
+            if (!out.flush())
+            {
+                out.close();
+                std::remove(tempPath.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+
+        return true;
+#else
+        int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (fd == -1)
+        {
+            return false;
+        }
+
+        // NOTE(yuval): The file's data has to reach the disk before the rename does,
+        //              or a power loss can leave an empty or partly written file behind the new name
+        bool written = WriteAll(fd, &header, sizeof(header)) &&
+                       WriteAll(fd, records.data(), records.size() * sizeof(ScheduleRecord)) &&
+                       ::fsync(fd) == 0;
+
+        if (::close(fd) != 0 || !written || std::rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            ::unlink(tempPath.c_str());
+            return false;
+        }
+
+        return SyncParentDirectory(path);
+#endif
+    }
+
+    bool ScheduleSnapshot::Open(const std::string& path)
+    {
+        Close();
+
+#ifdef _WIN32
+        // NOTE(yuval): Without mmap the file is read into a buffer of 8 byte words, so the records are aligned
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+
+        if (!in)
+        {
+            return false;
+        }
+
+        std::size_t length = static_cast<std::size_t>(in.tellg());
+        std::unique_ptr<std::uint64_t[]> buffer(new std::uint64_t[length / sizeof(std::uint64_t) + 1]);
+        in.seekg(0);
+
+        if (!in.read(reinterpret_cast<char*>(buffer.get()), static_cast<std::streamsize>(length)))
+        {
+            return false;
+        }
+
+        m_Data = buffer.release();
+        m_Length = length;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+
+        if (fd == -1)
+        {
+            return false;
+        }
+
+        struct stat fileStat;
+
+        if (::fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* data = ::mmap(nullptr, static_cast<std::size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+
+        m_Data = data;
+        m_Length = static_cast<std::size_t>(fileStat.st_size);
+#endif
+
+        const SnapshotHeader* header = static_cast<const SnapshotHeader*>(m_Data);
+
+        if (m_Length < sizeof(SnapshotHeader) || std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != SNAPSHOT_VERSION || header->recordSize != sizeof(ScheduleRecord) ||
+            header->count > (m_Length - sizeof(SnapshotHeader)) / sizeof(ScheduleRecord))
+        {
+            Close();
+            return false;
+        }
+
+        m_Records = reinterpret_cast<const ScheduleRecord*>(header + 1);
+        m_Count = static_cast<std::size_t>(header->count);
+
+        return true;
+    }
+
+    void ScheduleSnapshot::Close()
+    {
+        if (m_Data == nullptr)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        delete[] static_cast<std::uint64_t*>(m_Data);
+#else
+        ::munmap(m_Data, m_Length);
+#endif
+
+        m_Data = nullptr;
+        m_Length = 0;
+        m_Records = nullptr;
+        m_Count = 0;
+    }
+}
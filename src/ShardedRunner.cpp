@@ -0,0 +1,438 @@
+#include "Jobs/ShardedRunner.h"
+#include "Jobs/Job.h"
+#include <algorithm>
+
+#if JOBS_POLL_FD
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+namespace Jobs
+{
+    ShardedRunner::ShardedRunner(unsigned int shardCount, unsigned int maxJobs,
+                                 JobStoreType::Type storeType, ExecutorType::Type executorType)
+        : ShardedRunner(shardCount, Executor::Create(executorType, maxJobs), storeType)
+    {
+    }
+
+    ShardedRunner::ShardedRunner(unsigned int shardCount, std::shared_ptr<Executor> executor,
+                                 JobStoreType::Type storeType, std::shared_ptr<Clock> clock)
+        : m_Executor(std::move(executor)), m_JobCount(0), m_PollFd(-1)
+    {
+        if (shardCount == 0)
+        {
+            shardCount = 1;
+        }
+
+        for (unsigned int i = 0; i < shardCount; ++i)
+        {
+            m_Shards.emplace_back(new Runner(m_Executor, storeType, clock));
+        }
+    }
+
+    ShardedRunner::~ShardedRunner()
+    {
+        StopExportingMetrics();
+        Stop();
+        Clear();
+
+        // NOTE(yuval): The shards' lifetimes end before the shared executor is shut down,
+        //              so a late completion isn't submitted to it (see Runner::~Runner).
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->GetLifetime()->End();
+        }
+
+        // NOTE(yuval): The shared executor has to finish the jobs that are still running
+        //              before the shards they belong to are destroyed.
+        m_Executor->Shutdown();
+
+        for (std::size_t i = 0; i < m_Lanes.size(); ++i)
+        {
+            // A lane that serves several classes is shut down once
+            if (m_Lanes[i] != nullptr && std::find(m_Lanes.begin(), m_Lanes.begin() + i, m_Lanes[i]) == m_Lanes.begin() + i)
+            {
+                m_Lanes[i]->Shutdown();
+            }
+        }
+
+#if JOBS_POLL_FD
+        if (m_PollFd != -1)
+        {
+            ::close(m_PollFd);
+        }
+#endif
+    }
+
+    void ShardedRunner::Run()
+    {
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->Run();
+        }
+    }
+
+    void ShardedRunner::Stop()
+    {
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->Stop();
+        }
+    }
+
+    int ShardedRunner::GetPollFd()
+    {
+#if JOBS_POLL_FD
+        if (m_PollFd != -1)
+        {
+            return m_PollFd;
+        }
+
+        std::vector<int> shardFds;
+
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shardFds.push_back(shard->GetPollFd());
+        }
+
+        int pollFd = ::epoll_create1(EPOLL_CLOEXEC);
+
+        if (pollFd == -1)
+        {
+            throw JobException("The Runner Has No Poll Fd");
+        }
+
+        // NOTE(yuval): Every shard's event holds its index, so only the shards that are ready are processed
+        for (std::size_t i = 0; i < shardFds.size(); ++i)
+        {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.u32 = static_cast<std::uint32_t>(i);
+
+            if (::epoll_ctl(pollFd, EPOLL_CTL_ADD, shardFds[i], &event) != 0)
+            {
+                ::close(pollFd);
+                throw JobException("The Runner Has No Poll Fd");
+            }
+        }
+
+        m_PollFd = pollFd;
+        return m_PollFd;
+#else
+        throw JobException("The Runner Has No Poll Fd");
+#endif
+    }
+
+    void ShardedRunner::ProcessReady()
+    {
+#if JOBS_POLL_FD
+        if (m_PollFd == -1)
+        {
+            return;
+        }
+
+        constexpr int MAX_EVENTS = 64;
+        epoll_event events[MAX_EVENTS];
+        int count;
+
+        do
+        {
+            count = ::epoll_wait(m_PollFd, events, MAX_EVENTS, 0);
+
+            for (int i = 0; i < count; ++i)
+            {
+                m_Shards[events[i].data.u32]->ProcessReady();
+            }
+        } while (count == MAX_EVENTS);
+#endif
+    }
+
+    void ShardedRunner::RunPending()
+    {
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->RunPending();
+        }
+    }
+
+    void ShardedRunner::RunAll()
+    {
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->RunAll();
+        }
+    }
+
+    void ShardedRunner::AdvanceClock(Clock::Duration duration)
+    {
+        // NOTE(yuval): The shards share the clock
+        VirtualClock* clock = dynamic_cast<VirtualClock*>(&m_Shards[0]->GetClock());
+
+        if (clock == nullptr)
+        {
+            throw JobException("Only A Virtual Clock Can Be Advanced");
+        }
+
+        JOB_TIME_TYPE target = clock->Now() + duration;
+
+        // Stepping to the first run time (of a job or a timer) of all the shards every time
+        for (;;)
+        {
+            JOB_TIME_TYPE nextRunTime = JOB_TIME_TYPE::max();
+
+            for (std::unique_ptr<Runner>& shard : m_Shards)
+            {
+                JOB_TIME_TYPE shardNextRunTime;
+
+                if (shard->NextWakeupTime(shardNextRunTime) && shardNextRunTime < nextRunTime)
+                {
+                    nextRunTime = shardNextRunTime;
+                }
+            }
+
+            if (nextRunTime > target)
+            {
+                break;
+            }
+
+            clock->AdvanceTo(nextRunTime);
+            RunPending();
+        }
+
+        clock->AdvanceTo(target);
+        RunPending();
+    }
+
+    void ShardedRunner::Reserve(std::size_t jobCount)
+    {
+        // NOTE(yuval): The jobs are hashed to the shards, so a shard might get a few more than its share
+        std::size_t shardJobCount = (jobCount + m_Shards.size() - 1) / m_Shards.size();
+
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->Reserve(shardJobCount);
+        }
+
+        m_Executor->Reserve(jobCount);
+    }
+
+    void ShardedRunner::SetLane(JobPriority::Class priority, std::shared_ptr<Executor> executor)
+    {
+        m_Lanes[priority] = executor == m_Executor ? nullptr : executor;
+
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->SetLane(priority, executor);
+        }
+    }
+
+    void ShardedRunner::Disperse(Clock::Duration window)
+    {
+        for (std::size_t i = 0; i < m_Shards.size(); ++i)
+        {
+            m_Shards[i]->Disperse(window, static_cast<std::uint32_t>(i));
+        }
+    }
+
+    void ShardedRunner::ThrottleDispatch(std::size_t maxJobs, Clock::Duration tick)
+    {
+        // NOTE(yuval): A throttle that is set at all lets every shard dispatch at least one job per tick
+        std::size_t shardJobs = maxJobs == 0 ? 0 : std::max<std::size_t>(maxJobs / m_Shards.size(), 1);
+
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->ThrottleDispatch(shardJobs, tick);
+        }
+    }
+
+    void ShardedRunner::Clear()
+    {
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            shard->Clear();
+        }
+    }
+
+    void ShardedRunner::CancelJob(Job* job)
+    {
+        if (job == nullptr)
+        {
+            return;
+        }
+
+        Runner* shard = FindShard(job->Handle());
+
+        if (shard != nullptr)
+        {
+            shard->CancelJob(job);
+        }
+    }
+
+    bool ShardedRunner::CancelJob(const JobHandle& handle)
+    {
+        Runner* shard = FindShard(handle);
+        return shard != nullptr && shard->CancelJob(handle);
+    }
+
+    Job* ShardedRunner::GetJob(const JobHandle& handle)
+    {
+        Runner* shard = FindShard(handle);
+        return shard == nullptr ? nullptr : shard->GetJob(handle);
+    }
+
+    Job* ShardedRunner::FindJob(const JOB_FUNC_TYPE& fn)
+    {
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            Job* job = shard->FindJob(fn);
+
+            if (job != nullptr)
+            {
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    Job* ShardedRunner::FindJob(const std::string& name)
+    {
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            Job* job = shard->FindJob(name);
+
+            if (job != nullptr)
+            {
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    std::vector<JobHandle> ShardedRunner::FindByTag(const std::string& tag)
+    {
+        std::vector<JobHandle> handles;
+
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            std::vector<JobHandle> shardHandles = shard->FindByTag(tag);
+            handles.insert(handles.end(), shardHandles.begin(), shardHandles.end());
+        }
+
+        return handles;
+    }
+
+    std::size_t ShardedRunner::CancelByTag(const std::string& tag)
+    {
+        std::size_t canceled = 0;
+
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            canceled += shard->CancelByTag(tag);
+        }
+
+        return canceled;
+    }
+
+    Job& ShardedRunner::Every(int interval)
+    {
+        // Fibonacci hashing the job's sequence number spreads consecutive jobs over the shards
+        std::uint64_t hash = (m_JobCount++ + 1) * 0x9E3779B97F4A7C15ull;
+        std::size_t shard = static_cast<std::size_t>((hash >> 32) % m_Shards.size());
+
+        return m_Shards[shard]->Every(interval);
+    }
+
+    std::string ShardedRunner::NextRun()
+    {
+        Runner* shard = NextRunningShard();
+
+        if (shard == nullptr)
+        {
+            return std::string("There Are No Pending Jobs To Run");
+        }
+
+        return shard->NextRun();
+    }
+
+    int ShardedRunner::IdleSeconds()
+    {
+        Runner* shard = NextRunningShard();
+        return shard == nullptr ? -1 : shard->IdleSeconds();
+    }
+
+    RunnerMetrics ShardedRunner::Metrics()
+    {
+        // NOTE(yuval): The shards share the executor, so its metrics are only taken from the first shard
+        RunnerMetrics metrics = m_Shards[0]->Metrics();
+
+        for (std::size_t i = 1; i < m_Shards.size(); ++i)
+        {
+            metrics.AddRunner(m_Shards[i]->Metrics());
+        }
+
+        return metrics;
+    }
+
+    void ShardedRunner::WriteMetrics(std::ostream& out)
+    {
+        WritePrometheusText(out, Metrics());
+    }
+
+    void ShardedRunner::ExportMetrics(const std::string& path, std::chrono::milliseconds period)
+    {
+        StopExportingMetrics();
+        m_MetricsExporter.reset(new MetricsExporter([this, path]
+        {
+            WritePrometheusFile(path, Metrics());
+        }, period));
+    }
+
+    void ShardedRunner::ExportMetrics(std::ostream& out, std::chrono::milliseconds period)
+    {
+        StopExportingMetrics();
+        m_MetricsExporter.reset(new MetricsExporter([this, &out]
+        {
+            WriteMetrics(out);
+            out.flush();
+        }, period));
+    }
+
+    void ShardedRunner::StopExportingMetrics()
+    {
+        m_MetricsExporter.reset();
+    }
+
+    Runner* ShardedRunner::FindShard(const JobHandle& handle) const
+    {
+        for (const std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            if (shard.get() == handle.GetRunner())
+            {
+                return shard.get();
+            }
+        }
+
+        return nullptr;
+    }
+
+    Runner* ShardedRunner::NextRunningShard()
+    {
+        Runner* nextShard = nullptr;
+        JOB_TIME_TYPE nextRunTime = JOB_TIME_TYPE::max();
+
+        for (std::unique_ptr<Runner>& shard : m_Shards)
+        {
+            JOB_TIME_TYPE shardNextRunTime;
+
+            if (shard->NextRunningJobTime(shardNextRunTime) && shardNextRunTime < nextRunTime)
+            {
+                nextShard = shard.get();
+                nextRunTime = shardNextRunTime;
+            }
+        }
+
+        return nextShard;
+    }
+}
@@ -0,0 +1,39 @@
+#include "Jobs/StripedCounter.h"
+
+namespace Jobs
+{
+    namespace
+    {
+        std::atomic<std::size_t> s_NextStripe(0);
+    }
+
+    std::size_t CurrentStripe()
+    {
+        // NOTE(yuval): Threads get their stripes round robin, so up to STRIPE_COUNT
+        //              threads never share one.
+        thread_local std::size_t t_Stripe =
+            s_NextStripe.fetch_add(1, std::memory_order_relaxed) % StripedCounter::STRIPE_COUNT;
+
+        return t_Stripe;
+    }
+
+    StripedCounter::StripedCounter()
+    {
+        for (Stripe& stripe : m_Stripes)
+        {
+            stripe.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t StripedCounter::Load() const
+    {
+        std::uint64_t sum = 0;
+
+        for (const Stripe& stripe : m_Stripes)
+        {
+            sum += stripe.value.load(std::memory_order_relaxed);
+        }
+
+        return sum;
+    }
+}
@@ -0,0 +1,123 @@
+#include "Jobs/TaskDeque.h"
+
+namespace Jobs
+{
+    TaskDeque::Array::Array(std::int64_t capacity)
+        : capacity(capacity), tasks(new std::atomic<Task*>[static_cast<std::size_t>(capacity)])
+    {
+    }
+
+    TaskDeque::TaskDeque(std::int64_t capacity)
+        : m_Top(0), m_Bottom(0)
+    {
+        // Rounding the capacity up to a power of two
+        std::int64_t arrayCapacity = 1;
+
+        while (arrayCapacity < capacity)
+        {
+            arrayCapacity <<= 1;
+        }
+
+        m_Arrays.emplace_back(new Array(arrayCapacity));
+        m_Array.store(m_Arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    TaskDeque::~TaskDeque()
+    {
+    }
+
+    void TaskDeque::Push(Task* task)
+    {
+        std::int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+        std::int64_t top = m_Top.load(std::memory_order_acquire);
+        Array* array = m_Array.load(std::memory_order_relaxed);
+
+        if (bottom - top > array->capacity - 1)
+        {
+            array = Grow(array, top, bottom);
+        }
+
+        array->Put(bottom, task);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    Task* TaskDeque::Pop()
+    {
+        std::int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+        Array* array = m_Array.load(std::memory_order_relaxed);
+
+        m_Bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        std::int64_t top = m_Top.load(std::memory_order_relaxed);
+
+        // The deque is empty
+        if (top > bottom)
+        {
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Task* task = array->Get(bottom);
+
+        // The last task in the deque, racing the thieves for it
+        if (top == bottom)
+        {
+            if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                               std::memory_order_relaxed))
+            {
+                task = nullptr;
+            }
+
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return task;
+    }
+
+    Task* TaskDeque::Steal()
+    {
+        std::int64_t top = m_Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+        {
+            return nullptr;
+        }
+
+        Array* array = m_Array.load(std::memory_order_acquire);
+        Task* task = array->Get(top);
+
+        // Another thief or the owner took the task first
+        if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+
+        return task;
+    }
+
+    std::int64_t TaskDeque::Size() const
+    {
+        std::int64_t size = m_Bottom.load(std::memory_order_relaxed) - m_Top.load(std::memory_order_relaxed);
+        return size > 0 ? size : 0;
+    }
+
+    TaskDeque::Array* TaskDeque::Grow(Array* array, std::int64_t top, std::int64_t bottom)
+    {
+        Array* grown = new Array(array->capacity * 2);
+
+        for (std::int64_t i = top; i < bottom; ++i)
+        {
+            grown->Put(i, array->Get(i));
+        }
+
+        m_Arrays.emplace_back(grown);
+        m_Array.store(grown, std::memory_order_release);
+
+        return grown;
+    }
+}
@@ -0,0 +1,75 @@
+#include "Jobs/ThreadPoolExecutor.h"
+
+namespace Jobs
+{
+    ThreadPoolExecutor::ThreadPoolExecutor(unsigned int workerCount)
+        : m_WorkerCount(workerCount == 0 ? 1 : workerCount), m_WorkerStates(new WorkerState[m_WorkerCount]),
+          m_Threads(static_cast<int>(m_WorkerCount))
+    {
+        for (unsigned int i = 0; i < m_WorkerCount; ++i)
+        {
+            m_WorkerStates[i].startedTasks.store(0, std::memory_order_relaxed);
+            m_WorkerStates[i].busy.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    ThreadPoolExecutor::~ThreadPoolExecutor()
+    {
+        Shutdown();
+    }
+
+    void ThreadPoolExecutor::Submit(Task* task)
+    {
+        m_SubmittedTasks.Add();
+
+        m_Threads.push([this, task](int id)
+        {
+            WorkerState& state = m_WorkerStates[id];
+
+            state.startedTasks.store(state.startedTasks.load(std::memory_order_relaxed) + 1,
+                                     std::memory_order_relaxed);
+            state.busy.store(true, std::memory_order_relaxed);
+
+            task->Execute();
+
+            state.busy.store(false, std::memory_order_relaxed);
+        });
+    }
+
+    void ThreadPoolExecutor::Shutdown()
+    {
+        m_Threads.stop(true);
+    }
+
+    unsigned int ThreadPoolExecutor::WorkerCount() const
+    {
+        return m_WorkerCount;
+    }
+
+    std::size_t ThreadPoolExecutor::QueuedTaskCount() const
+    {
+        std::uint64_t startedTasks = 0;
+
+        for (unsigned int i = 0; i < m_WorkerCount; ++i)
+        {
+            startedTasks += m_WorkerStates[i].startedTasks.load(std::memory_order_relaxed);
+        }
+
+        // NOTE(yuval): The counters are read without synchronizing with the workers,
+        //              so a task that just started might not be counted as submitted yet.
+        std::uint64_t submittedTasks = m_SubmittedTasks.Load();
+        return submittedTasks > startedTasks ? static_cast<std::size_t>(submittedTasks - startedTasks) : 0;
+    }
+
+    unsigned int ThreadPoolExecutor::BusyWorkerCount() const
+    {
+        unsigned int busyWorkers = 0;
+
+        for (unsigned int i = 0; i < m_WorkerCount; ++i)
+        {
+            busyWorkers += m_WorkerStates[i].busy.load(std::memory_order_relaxed) ? 1 : 0;
+        }
+
+        return busyWorkers;
+    }
+}
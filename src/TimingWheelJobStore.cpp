@@ -0,0 +1,458 @@
+#include "Jobs/TimingWheelJobStore.h"
+#include "Jobs/Bits.h"
+#include <algorithm>
+#include <limits>
+
+namespace Jobs
+{
+    namespace
+    {
+        // Number of slots in every level: milliseconds, seconds, minutes, hours, days
+        const std::int64_t LEVEL_SLOTS[] = { 1000, 60, 60, 24, 365 };
+
+        // Number of ticks (milliseconds) covered by a single slot of every level
+        const std::int64_t LEVEL_SPANS[] = { 1, 1000, 60 * 1000, 60 * 60 * 1000, 24 * 60 * 60 * 1000 };
+
+        // Index of every level's first slot in the list array
+        const std::size_t LEVEL_OFFSETS[] = { 0, 1000, 1060, 1120, 1144 };
+
+        inline std::int64_t BlockSpan(std::size_t level)
+        {
+            return LEVEL_SPANS[level] * LEVEL_SLOTS[level];
+        }
+
+        inline std::int64_t SlotIndex(std::int64_t tick, std::size_t level)
+        {
+            return (tick / LEVEL_SPANS[level]) % LEVEL_SLOTS[level];
+        }
+
+        // Returns the first tick at or after the given time
+        inline std::int64_t CeilTick(JOB_TIME_TYPE time)
+        {
+            std::chrono::milliseconds tick = std::chrono::ceil<std::chrono::milliseconds>(time.time_since_epoch());
+            return static_cast<std::int64_t>(tick.count());
+        }
+
+        // Returns the time at which a tick starts
+        inline JOB_TIME_TYPE TickTime(std::int64_t tick)
+        {
+            return JOB_TIME_TYPE(std::chrono::milliseconds(tick));
+        }
+
+        // Returns the last tick at or before the given time
+        inline std::int64_t FloorTick(JOB_TIME_TYPE time)
+        {
+            std::chrono::milliseconds tick = std::chrono::floor<std::chrono::milliseconds>(time.time_since_epoch());
+            return static_cast<std::int64_t>(tick.count());
+        }
+    }
+
+    TimingWheelJobStore::TimingWheelJobStore(JOB_TIME_TYPE now)
+        : m_Current(FloorTick(now)), m_Occupied(), m_LevelSizes(), m_Size(0)
+    {
+        for (std::size_t list = 0; list < LIST_COUNT; ++list)
+        {
+            m_Lists[list] = NO_NODE;
+            m_MinTicks[list] = std::numeric_limits<std::int64_t>::max();
+            m_StaleMins[list] = false;
+        }
+    }
+
+    TimingWheelJobStore::~TimingWheelJobStore()
+    {
+    }
+
+    void TimingWheelJobStore::Insert(JOB_TIME_TYPE time, Job* job)
+    {
+        std::uint32_t node = job->Handle().Index();
+
+        if (node >= m_Nodes.size())
+        {
+            m_Nodes.resize(node + 1, Node{ nullptr, 0, 0, NO_NODE, NO_NODE });
+        }
+
+        // Re-inserting a stored job moves it to its new run time
+        if (m_Nodes[node].job != nullptr)
+        {
+            Unlink(node);
+        }
+        else
+        {
+            ++m_Size;
+        }
+
+        m_Nodes[node].job = job;
+        m_Nodes[node].tick = CeilTick(time);
+        Place(node);
+    }
+
+    bool TimingWheelJobStore::Remove(Job* job)
+    {
+        std::uint32_t node = job->Handle().Index();
+
+        if (node >= m_Nodes.size() || m_Nodes[node].job == nullptr)
+        {
+            return false;
+        }
+
+        Unlink(node);
+        m_Nodes[node].job = nullptr;
+        --m_Size;
+        return true;
+    }
+
+    void TimingWheelJobStore::PopExpired(JOB_TIME_TYPE now, std::vector<Job*>& expired)
+    {
+        const std::int64_t nowTick = FloorTick(now);
+        const std::size_t topLevel = LEVEL_COUNT - 1;
+
+        Collect(READY_LIST, expired);
+
+        while (m_Current < nowTick)
+        {
+            // Jumping straight to the next tick that has something to collect or cascade
+            std::int64_t nextTick = NextEventTick();
+
+            if (nextTick > nowTick)
+            {
+                m_Current = nowTick;
+                break;
+            }
+
+            m_Current = nextTick;
+
+            // Cascading from the top level down so every node ends up in the lowest level it fits
+            if (m_Current % BlockSpan(topLevel) == 0)
+            {
+                Cascade(OVERFLOW_LIST);
+            }
+
+            for (std::size_t level = topLevel; level > 0; --level)
+            {
+                if (m_Current % LEVEL_SPANS[level] == 0)
+                {
+                    Cascade(LEVEL_OFFSETS[level] + SlotIndex(m_Current, level));
+                }
+            }
+
+            Collect(LEVEL_OFFSETS[0] + SlotIndex(m_Current, 0), expired);
+            Collect(READY_LIST, expired);
+        }
+    }
+
+    void TimingWheelJobStore::PopAll(std::vector<Job*>& jobs)
+    {
+        for (Node& node : m_Nodes)
+        {
+            if (node.job != nullptr)
+            {
+                jobs.push_back(node.job);
+                node.job = nullptr;
+            }
+        }
+
+        for (std::size_t list = 0; list < LIST_COUNT; ++list)
+        {
+            m_Lists[list] = NO_NODE;
+            m_MinTicks[list] = std::numeric_limits<std::int64_t>::max();
+            m_StaleMins[list] = false;
+        }
+
+        for (std::uint64_t& word : m_Occupied)
+        {
+            word = 0;
+        }
+
+        for (std::size_t& levelSize : m_LevelSizes)
+        {
+            levelSize = 0;
+        }
+
+        m_Size = 0;
+    }
+
+    Job* TimingWheelJobStore::Find(const std::function<bool(Job*)>& pred) const
+    {
+        for (const Node& node : m_Nodes)
+        {
+            if (node.job != nullptr && pred(node.job))
+            {
+                return node.job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool TimingWheelJobStore::NextRunTime(JOB_TIME_TYPE& time) const
+    {
+        if (m_Lists[READY_LIST] != NO_NODE)
+        {
+            time = TickTime(MinTick(READY_LIST));
+            return true;
+        }
+
+        // The levels are ordered, so the earliest job is in the first occupied slot of the lowest occupied level
+        for (std::size_t level = 0; level < LEVEL_COUNT; ++level)
+        {
+            if (m_LevelSizes[level] == 0)
+            {
+                continue;
+            }
+
+            std::size_t levelEnd = LEVEL_OFFSETS[level] + LEVEL_SLOTS[level];
+            std::size_t list = NextOccupiedSlot(LEVEL_OFFSETS[level] + SlotIndex(m_Current, level) + 1,
+                                                levelEnd);
+
+            if (list != levelEnd)
+            {
+                time = TickTime(MinTick(list));
+                return true;
+            }
+        }
+
+        if (m_Lists[OVERFLOW_LIST] != NO_NODE)
+        {
+            time = TickTime(MinTick(OVERFLOW_LIST));
+            return true;
+        }
+
+        return false;
+    }
+
+    std::size_t TimingWheelJobStore::Size() const
+    {
+        return m_Size;
+    }
+
+    void TimingWheelJobStore::Reserve(std::size_t jobCount)
+    {
+        m_Nodes.reserve(jobCount);
+    }
+
+    void TimingWheelJobStore::Place(std::uint32_t node)
+    {
+        std::int64_t tick = m_Nodes[node].tick;
+
+        if (tick <= m_Current)
+        {
+            Link(node, READY_LIST);
+            return;
+        }
+
+        // A node belongs to the lowest level whose block it shares with the current tick
+        for (std::size_t level = 0; level < LEVEL_COUNT; ++level)
+        {
+            if (tick / BlockSpan(level) == m_Current / BlockSpan(level))
+            {
+                Link(node, LEVEL_OFFSETS[level] + SlotIndex(tick, level));
+                return;
+            }
+        }
+
+        Link(node, OVERFLOW_LIST);
+    }
+
+    void TimingWheelJobStore::Link(std::uint32_t node, std::size_t list)
+    {
+        Node& linked = m_Nodes[node];
+
+        linked.list = static_cast<std::uint32_t>(list);
+        linked.prev = NO_NODE;
+        linked.next = m_Lists[list];
+
+        if (linked.next != NO_NODE)
+        {
+            m_Nodes[linked.next].prev = node;
+        }
+
+        if (linked.tick < m_MinTicks[list])
+        {
+            m_MinTicks[list] = linked.tick;
+            m_StaleMins[list] = false;
+        }
+
+        m_Lists[list] = node;
+
+        std::size_t level = LevelOf(list);
+
+        if (level < LEVEL_COUNT)
+        {
+            ++m_LevelSizes[level];
+            m_Occupied[list / 64] |= std::uint64_t(1) << (list % 64);
+        }
+    }
+
+    void TimingWheelJobStore::Unlink(std::uint32_t node)
+    {
+        Node& unlinked = m_Nodes[node];
+
+        if (unlinked.prev != NO_NODE)
+        {
+            m_Nodes[unlinked.prev].next = unlinked.next;
+        }
+        else
+        {
+            m_Lists[unlinked.list] = unlinked.next;
+        }
+
+        if (unlinked.next != NO_NODE)
+        {
+            m_Nodes[unlinked.next].prev = unlinked.prev;
+        }
+
+        // NOTE(yuval): Finding the list's next earliest tick would walk the list, so the cached
+        //              tick is only marked stale (see MinTick)
+        if (m_Lists[unlinked.list] == NO_NODE)
+        {
+            m_MinTicks[unlinked.list] = std::numeric_limits<std::int64_t>::max();
+            m_StaleMins[unlinked.list] = false;
+        }
+        else if (unlinked.tick == m_MinTicks[unlinked.list])
+        {
+            m_StaleMins[unlinked.list] = true;
+        }
+
+        std::size_t level = LevelOf(unlinked.list);
+
+        if (level < LEVEL_COUNT)
+        {
+            --m_LevelSizes[level];
+
+            if (m_Lists[unlinked.list] == NO_NODE)
+            {
+                m_Occupied[unlinked.list / 64] &= ~(std::uint64_t(1) << (unlinked.list % 64));
+            }
+        }
+    }
+
+    void TimingWheelJobStore::Cascade(std::size_t list)
+    {
+        std::uint32_t node = m_Lists[list];
+
+        while (node != NO_NODE)
+        {
+            std::uint32_t next = m_Nodes[node].next;
+
+            Unlink(node);
+            Place(node);
+
+            node = next;
+        }
+    }
+
+    void TimingWheelJobStore::Collect(std::size_t list, std::vector<Job*>& expired)
+    {
+        std::uint32_t node = m_Lists[list];
+
+        while (node != NO_NODE)
+        {
+            std::uint32_t next = m_Nodes[node].next;
+
+            Unlink(node);
+            expired.push_back(m_Nodes[node].job);
+            m_Nodes[node].job = nullptr;
+            --m_Size;
+
+            node = next;
+        }
+    }
+
+    std::int64_t TimingWheelJobStore::NextEventTick() const
+    {
+        for (std::size_t level = 0; level < LEVEL_COUNT; ++level)
+        {
+            if (m_LevelSizes[level] == 0)
+            {
+                continue;
+            }
+
+            std::int64_t blockStart = (m_Current / BlockSpan(level)) * BlockSpan(level);
+            std::size_t levelEnd = LEVEL_OFFSETS[level] + LEVEL_SLOTS[level];
+            std::size_t list = NextOccupiedSlot(LEVEL_OFFSETS[level] + SlotIndex(m_Current, level) + 1,
+                                                levelEnd);
+
+            if (list != levelEnd)
+            {
+                return blockStart + static_cast<std::int64_t>(list - LEVEL_OFFSETS[level]) * LEVEL_SPANS[level];
+            }
+
+            return blockStart + BlockSpan(level);
+        }
+
+        if (m_Lists[OVERFLOW_LIST] != NO_NODE)
+        {
+            std::int64_t topBlockSpan = BlockSpan(LEVEL_COUNT - 1);
+            return (m_Current / topBlockSpan + 1) * topBlockSpan;
+        }
+
+        return std::numeric_limits<std::int64_t>::max();
+    }
+
+    std::size_t TimingWheelJobStore::NextOccupiedSlot(std::size_t first, std::size_t last) const
+    {
+        std::size_t list = first;
+
+        while (list < last)
+        {
+            // Masking out the bits below the current list and scanning for the lowest set bit
+            std::uint64_t word = m_Occupied[list / 64] & (~std::uint64_t(0) << (list % 64));
+
+            if (word != 0)
+            {
+                list = (list / 64) * 64 + LowestSetBit(word);
+                return list < last ? list : last;
+            }
+
+            list = (list / 64 + 1) * 64;
+        }
+
+        return last;
+    }
+
+    std::int64_t TimingWheelJobStore::MinTick(std::size_t list) const
+    {
+        if (!m_StaleMins[list])
+        {
+            return m_MinTicks[list];
+        }
+
+        // The remaining nodes run no earlier than the cached tick, and no earlier than the wheel reaches their list
+        std::size_t level = LevelOf(list);
+
+        if (level == 0)
+        {
+            // All the nodes of a milliseconds slot share its tick
+            return m_Nodes[m_Lists[list]].tick;
+        }
+
+        if (level < LEVEL_COUNT)
+        {
+            std::int64_t blockStart = (m_Current / BlockSpan(level)) * BlockSpan(level);
+            std::int64_t slotStart = blockStart + static_cast<std::int64_t>(list - LEVEL_OFFSETS[level]) * LEVEL_SPANS[level];
+            return std::max(m_MinTicks[list], slotStart);
+        }
+
+        if (list == OVERFLOW_LIST)
+        {
+            std::int64_t topBlockSpan = BlockSpan(LEVEL_COUNT - 1);
+            return std::max(m_MinTicks[list], (m_Current / topBlockSpan + 1) * topBlockSpan);
+        }
+
+        // The ready nodes are all due
+        return m_MinTicks[list];
+    }
+
+    std::size_t TimingWheelJobStore::LevelOf(std::size_t list)
+    {
+        for (std::size_t level = LEVEL_COUNT; level > 0; --level)
+        {
+            if (list >= LEVEL_OFFSETS[level - 1] && list < SLOT_COUNT)
+            {
+                return level - 1;
+            }
+        }
+
+        return LEVEL_COUNT;
+    }
+}
@@ -0,0 +1,326 @@
+#include "Jobs/WorkStealingExecutor.h"
+#include "Jobs/Bits.h"
+
+namespace Jobs
+{
+    namespace
+    {
+        // The executor and worker that the current thread belongs to
+        thread_local WorkStealingExecutor* t_Executor = nullptr;
+        thread_local std::size_t t_WorkerIndex = 0;
+
+        // Picks the inboxes of the tasks that the thread submits from outside the executor (zero until seeded)
+        thread_local std::uint64_t t_RandomState = 0;
+
+        inline std::uint64_t NextRandom(std::uint64_t& state)
+        {
+            // xorshift64
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+    }
+
+    WorkStealingExecutor::WorkStealingExecutor(unsigned int workerCount)
+        : m_SleepingWorkers(0), m_WakeEpoch(0), m_IsStopping(false)
+    {
+        if (workerCount == 0)
+        {
+            workerCount = 1;
+        }
+
+        for (unsigned int i = 0; i < workerCount; ++i)
+        {
+            m_Workers.emplace_back(new Worker());
+            m_Workers.back()->randomState = 0x9E3779B97F4A7C15ull * (i + 1);
+            m_Workers.back()->busy.store(false, std::memory_order_relaxed);
+            m_Workers.back()->joinClaimed.store(false, std::memory_order_relaxed);
+        }
+
+        // NOTE(yuval): The workers are started only after all of them exist, so they can steal from each other
+        for (std::size_t i = 0; i < m_Workers.size(); ++i)
+        {
+            m_Workers[i]->thread = std::thread(&WorkStealingExecutor::WorkerLoop, this, i);
+        }
+    }
+
+    WorkStealingExecutor::~WorkStealingExecutor()
+    {
+        Shutdown();
+
+        // NOTE(yuval): A task that released the executor's last owner destroys the executor on one of its
+        //              workers, which can't join itself. Its thread is detached instead, and leaves its run loop
+        //              as soon as the task returns (see WorkerLoop).
+        if (t_Executor == this)
+        {
+            m_Workers[t_WorkerIndex]->thread.detach();
+            t_Executor = nullptr;
+        }
+    }
+
+    void WorkStealingExecutor::Submit(Task* task)
+    {
+        if (t_Executor == this)
+        {
+            // Tasks submitted by a worker stay on its own deque
+            m_Workers[t_WorkerIndex]->deque.Push(task);
+        }
+        else
+        {
+            // NOTE(yuval): Every submitting thread picks inboxes with a random state of its own,
+            //              so the submitting threads don't share a counter
+            if (t_RandomState == 0)
+            {
+                t_RandomState = MixBits(reinterpret_cast<std::uintptr_t>(&t_RandomState)) | 1;
+            }
+
+            Worker& worker = *m_Workers[NextRandom(t_RandomState) % m_Workers.size()];
+
+            std::lock_guard<std::mutex> lock(worker.inboxMutex);
+            worker.inbox.push_back(task);
+        }
+
+        WakeWorker();
+    }
+
+    void WorkStealingExecutor::Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+
+            m_IsStopping = true;
+            m_WakeEpoch.fetch_add(1, std::memory_order_relaxed);
+            m_SleepCV.notify_all();
+        }
+
+        // Every thread is joined by the first shutdown that claims it, a worker can't join itself
+        for (std::unique_ptr<Worker>& worker : m_Workers)
+        {
+            if (worker->thread.get_id() == std::this_thread::get_id() || worker->joinClaimed.exchange(true))
+            {
+                continue;
+            }
+
+            worker->thread.join();
+        }
+    }
+
+    unsigned int WorkStealingExecutor::WorkerCount() const
+    {
+        return static_cast<unsigned int>(m_Workers.size());
+    }
+
+    void WorkStealingExecutor::Reserve(std::size_t taskCount)
+    {
+        // NOTE(yuval): The deques grow on their own and keep their largest array,
+        //              only the inboxes have to be sized before any task is submitted.
+        for (std::unique_ptr<Worker>& worker : m_Workers)
+        {
+            std::lock_guard<std::mutex> lock(worker->inboxMutex);
+
+            worker->inbox.reserve(taskCount);
+            worker->drained.reserve(taskCount);
+        }
+    }
+
+    std::size_t WorkStealingExecutor::QueuedTaskCount() const
+    {
+        std::size_t queuedTasks = 0;
+
+        for (const std::unique_ptr<Worker>& worker : m_Workers)
+        {
+            // The deque size is an estimate that races with the owner and the thieves
+            std::int64_t dequeSize = worker->deque.Size();
+            queuedTasks += dequeSize > 0 ? static_cast<std::size_t>(dequeSize) : 0;
+
+            std::lock_guard<std::mutex> lock(worker->inboxMutex);
+            queuedTasks += worker->inbox.size();
+        }
+
+        return queuedTasks;
+    }
+
+    unsigned int WorkStealingExecutor::BusyWorkerCount() const
+    {
+        unsigned int busyWorkers = 0;
+
+        for (const std::unique_ptr<Worker>& worker : m_Workers)
+        {
+            busyWorkers += worker->busy.load(std::memory_order_relaxed) ? 1 : 0;
+        }
+
+        return busyWorkers;
+    }
+
+    void WorkStealingExecutor::WorkerLoop(std::size_t index)
+    {
+        t_Executor = this;
+        t_WorkerIndex = index;
+        Worker& worker = *m_Workers[index];
+
+        for (;;)
+        {
+            Task* task = FindTask(index);
+
+            if (task != nullptr)
+            {
+                worker.busy.store(true, std::memory_order_relaxed);
+                task->Execute();
+
+                // The task destroyed the executor, which detached this thread
+                if (t_Executor != this)
+                {
+                    return;
+                }
+
+                worker.busy.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            // NOTE(yuval): The worker counts itself as sleeping before it looks for tasks one last time,
+            //              and submitters look for sleeping workers after they queued a task, so either
+            //              the worker finds the task or the submitter bumps the epoch and wakes it up.
+            std::uint64_t epoch = m_WakeEpoch.load(std::memory_order_acquire);
+            m_SleepingWorkers.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (HasQueuedTasks())
+            {
+                m_SleepingWorkers.fetch_sub(1);
+                continue;
+            }
+
+            // Stopping only once all the queued tasks ran
+            if (m_IsStopping)
+            {
+                m_SleepingWorkers.fetch_sub(1);
+                break;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(m_SleepMutex);
+                m_SleepCV.wait(lock, [this, epoch]
+                {
+                    return m_WakeEpoch.load(std::memory_order_relaxed) != epoch || m_IsStopping;
+                });
+            }
+
+            m_SleepingWorkers.fetch_sub(1);
+        }
+
+        t_Executor = nullptr;
+    }
+
+    Task* WorkStealingExecutor::FindTask(std::size_t index)
+    {
+        Worker& worker = *m_Workers[index];
+        Task* task = worker.deque.Pop();
+
+        if (task == nullptr)
+        {
+            task = DrainInbox(worker);
+        }
+
+        if (task == nullptr)
+        {
+            task = Steal(index);
+        }
+
+        return task;
+    }
+
+    Task* WorkStealingExecutor::DrainInbox(Worker& worker)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker.inboxMutex);
+
+            if (worker.inbox.empty())
+            {
+                return nullptr;
+            }
+
+            // NOTE(yuval): Swapping keeps the capacity of both vectors, so draining doesn't allocate
+            worker.inbox.swap(worker.drained);
+        }
+
+        for (Task* task : worker.drained)
+        {
+            worker.deque.Push(task);
+        }
+
+        worker.drained.clear();
+        return worker.deque.Pop();
+    }
+
+    Task* WorkStealingExecutor::Steal(std::size_t index)
+    {
+        std::size_t workerCount = m_Workers.size();
+        std::size_t first = static_cast<std::size_t>(NextRandom(m_Workers[index]->randomState) % workerCount);
+
+        for (std::size_t i = 0; i < workerCount; ++i)
+        {
+            std::size_t victimIndex = (first + i) % workerCount;
+
+            if (victimIndex == index)
+            {
+                continue;
+            }
+
+            Worker& victim = *m_Workers[victimIndex];
+            Task* task = victim.deque.Steal();
+
+            if (task != nullptr)
+            {
+                return task;
+            }
+
+            // A busy victim might not get to its inbox for a while
+            std::unique_lock<std::mutex> lock(victim.inboxMutex, std::try_to_lock);
+
+            if (lock.owns_lock() && !victim.inbox.empty())
+            {
+                task = victim.inbox.back();
+                victim.inbox.pop_back();
+                return task;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool WorkStealingExecutor::HasQueuedTasks()
+    {
+        // NOTE(yuval): Unlike stealing, this waits for the inbox locks, so a contended inbox
+        //              isn't mistaken for an empty one
+        for (std::unique_ptr<Worker>& worker : m_Workers)
+        {
+            if (worker->deque.Size() > 0)
+            {
+                return true;
+            }
+
+            std::lock_guard<std::mutex> lock(worker->inboxMutex);
+
+            if (!worker->inbox.empty())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void WorkStealingExecutor::WakeWorker()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_SleepingWorkers.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+
+            m_WakeEpoch.fetch_add(1, std::memory_order_relaxed);
+            m_SleepCV.notify_one();
+        }
+    }
+}